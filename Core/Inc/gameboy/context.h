@@ -0,0 +1,29 @@
+/*
+ * context.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_CONTEXT_H_
+#define INC_GAMEBOY_CONTEXT_H_
+
+// The emulator is the set of module globals (cpu, irq, ppu, mem, ...),
+// accessed directly by the modules and opcode handlers. Build with
+// GAMEBOY_THREADS to make them thread local: each thread then runs its own
+// emulator from its own gameboy_init(), e.g. a batch of test ROMs across the
+// host cores. ROM buffers are only read and can be shared. The STM32 runs one
+// emulator with plain globals.
+//
+// The globals are not gathered into a context struct passed around: on the
+// F429 (Cortex-M4), a context pointer through every opcode handler takes a
+// register and adds a load to each access. Thread local accesses cost about
+// 4% of single thread speed on x86-64, gbrun keeps plain globals.
+
+#ifdef GAMEBOY_THREADS
+#define GAMEBOY_CONTEXT     _Thread_local
+#else
+#define GAMEBOY_CONTEXT
+#endif
+
+#endif /* INC_GAMEBOY_CONTEXT_H_ */
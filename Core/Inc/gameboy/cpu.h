@@ -8,28 +8,31 @@
 #ifndef INC_GAMEBOY_CPU_H_
 #define INC_GAMEBOY_CPU_H_
 
+#include <gameboy/context.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// Pairs are stored low byte first to be accessed as uint16_t on little endian
+// targets, bit-fields are allocated from the LSB
 struct cpu_reg_t
 {
 	union
 	{
 		struct
 		{
-			uint8_t A; // Accumulator
 			union
 			{
 				uint8_t F; // Flags
 				struct
 				{
-					uint8_t Z: 1; // Zero Flag
-					uint8_t N: 1; // Subtract Flag
-					uint8_t H: 1; // Half Carry Flag
-					uint8_t C: 1; // Carry Flag
 					uint8_t  : 4;
+					uint8_t C: 1; // Carry Flag
+					uint8_t H: 1; // Half Carry Flag
+					uint8_t N: 1; // Subtract Flag
+					uint8_t Z: 1; // Zero Flag
 				} Flags;
 			};
+			uint8_t A; // Accumulator
 		};
 		uint16_t AF;
 	};
@@ -38,8 +41,8 @@ struct cpu_reg_t
 	{
 		struct
 		{
-			uint8_t B;
 			uint8_t C;
+			uint8_t B;
 		};
 		uint16_t BC;
 	};
@@ -48,8 +51,8 @@ struct cpu_reg_t
 	{
 		struct
 		{
-			uint8_t D;
 			uint8_t E;
+			uint8_t D;
 		};
 		uint16_t DE;
 	};
@@ -58,26 +61,58 @@ struct cpu_reg_t
 	{
 		struct
 		{
-			uint8_t H;
 			uint8_t L;
+			uint8_t H;
 		};
 		uint16_t HL;
 	};
 	uint16_t SP; // Stack Pointer
 	uint16_t PC; // Program Counter
+
+#ifdef CPU_LAZY_FLAGS
+	// Last flag-setting operation, see gameboy/flags.h
+	struct
+	{
+		uint8_t op;
+		uint8_t a;
+		uint8_t b;
+		uint8_t c;
+		uint16_t r;
+	} Lazy;
+#endif
+};
+
+enum cpu_mode_t
+{
+    CPU_MODE_RUN = 0,
+    CPU_MODE_HALT,          // Sleeping until an IRQ is requested
+    CPU_MODE_HALT_BUG,      // Next opcode fetch doesn't increment PC
+    CPU_MODE_IDLE_LOOP,     // At the head of an idle loop, see gameboy/idle.h
+    CPU_MODE_BREAK,         // Leave cpu_run(), an event is due before its end
 };
 
 struct cpu_t
 {
     struct cpu_reg_t reg;
-    bool halted;
+    enum cpu_mode_t mode;
+    uint8_t idle_cycles; // Duration of one iteration of the idle loop
     uint8_t cycle_counter;
+    uint32_t cycles; // Executed cycles, wraps around
     bool prefix_cb;
 };
 
-extern struct cpu_t cpu;
+extern GAMEBOY_CONTEXT struct cpu_t cpu;
 
 void cpu_init(void);
 void cpu_exec(void);
+uint32_t cpu_run(uint32_t budget);
+void cpu_sync_flags(void);
+
+// Stop cpu_run() after the current instruction
+static inline void cpu_break(void)
+{
+    if (cpu.mode == CPU_MODE_RUN)
+        cpu.mode = CPU_MODE_BREAK;
+}
 
 #endif /* INC_GAMEBOY_CPU_H_ */
@@ -0,0 +1,150 @@
+/*
+ * flags.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_FLAGS_H_
+#define INC_GAMEBOY_FLAGS_H_
+
+#include <gameboy/cpu.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flags of the ALU opcodes, to be used through the macros on REG.
+//
+// Default: F is computed and written by every ALU opcode.
+// CPU_LAZY_FLAGS: ALU opcodes only record their operands and result in
+// REG.Lazy, flags are computed when read. Opcodes writing F directly call
+// FLAGS_SYNC() first, F is valid when REG.Lazy.op is FLAGS_OP_NONE.
+//
+// Both modes use flags_compute() so that they behave the same.
+
+#define FLAG_MASK_Z     0x80
+#define FLAG_MASK_N     0x40
+#define FLAG_MASK_H     0x20
+#define FLAG_MASK_C     0x10
+
+enum flags_op_t
+{
+    FLAGS_OP_NONE = 0,
+    FLAGS_OP_ADD,   // a + b + c = r
+    FLAGS_OP_SUB,   // a - b - c = r
+    FLAGS_OP_AND,
+    FLAGS_OP_OR,    // OR & XOR
+    FLAGS_OP_INC,   // C preserved in c
+    FLAGS_OP_DEC,   // C preserved in c
+};
+
+static inline uint8_t flags_compute(uint8_t op, uint8_t a, uint8_t b, uint16_t r, uint8_t c)
+{
+    uint8_t F = ((r & 0xFF) == 0) ? FLAG_MASK_Z : 0;
+
+    switch (op)
+    {
+        case FLAGS_OP_ADD:
+            F |= ((a ^ b ^ r) & 0x10) << 1;     // Carry from bit 3
+            F |= (r >> 4) & FLAG_MASK_C;        // Carry from bit 7
+            break;
+        case FLAGS_OP_SUB:
+            F |= FLAG_MASK_N;
+            F |= ((a ^ b ^ r) & 0x10) << 1;     // Borrow from bit 4
+            F |= (r >> 4) & FLAG_MASK_C;        // Borrow, r wrapped to 0xFFxx
+            break;
+        case FLAGS_OP_AND:
+            F |= FLAG_MASK_H;
+            break;
+        case FLAGS_OP_INC:
+            F |= ((r & 0x0F) == 0x00) ? FLAG_MASK_H : 0;
+            F |= c << 4;
+            break;
+        case FLAGS_OP_DEC:
+            F |= FLAG_MASK_N;
+            F |= ((r & 0x0F) == 0x0F) ? FLAG_MASK_H : 0;
+            F |= c << 4;
+            break;
+    }
+
+    return F;
+}
+
+#ifdef CPU_LAZY_FLAGS
+
+static inline void flags_record(struct cpu_reg_t *pReg, uint8_t op, uint8_t a, uint8_t b, uint16_t r, uint8_t c)
+{
+    pReg->Lazy.op = op;
+    pReg->Lazy.a = a;
+    pReg->Lazy.b = b;
+    pReg->Lazy.c = c;
+    pReg->Lazy.r = r;
+}
+
+static inline void flags_sync(struct cpu_reg_t *pReg)
+{
+    if (pReg->Lazy.op != FLAGS_OP_NONE)
+    {
+        pReg->F = flags_compute(pReg->Lazy.op, pReg->Lazy.a, pReg->Lazy.b, pReg->Lazy.r, pReg->Lazy.c);
+        pReg->Lazy.op = FLAGS_OP_NONE;
+    }
+}
+
+static inline uint8_t flag_z(struct cpu_reg_t *pReg)
+{
+    if (pReg->Lazy.op == FLAGS_OP_NONE)
+        return pReg->Flags.Z;
+    return (pReg->Lazy.r & 0xFF) == 0;
+}
+
+static inline uint8_t flag_c(struct cpu_reg_t *pReg)
+{
+    switch (pReg->Lazy.op)
+    {
+        case FLAGS_OP_NONE:
+            return pReg->Flags.C;
+        case FLAGS_OP_ADD:
+        case FLAGS_OP_SUB:
+            return (pReg->Lazy.r >> 8) & 0x01;
+        case FLAGS_OP_AND:
+        case FLAGS_OP_OR:
+            return 0;
+        default:
+            return pReg->Lazy.c;
+    }
+}
+
+#else
+
+static inline void flags_record(struct cpu_reg_t *pReg, uint8_t op, uint8_t a, uint8_t b, uint16_t r, uint8_t c)
+{
+    pReg->F = flags_compute(op, a, b, r, c);
+}
+
+static inline void flags_sync(struct cpu_reg_t *pReg)
+{
+    (void) pReg;
+}
+
+static inline uint8_t flag_z(struct cpu_reg_t *pReg)
+{
+    return pReg->Flags.Z;
+}
+
+static inline uint8_t flag_c(struct cpu_reg_t *pReg)
+{
+    return pReg->Flags.C;
+}
+
+#endif
+
+#define FLAG_Z()                    flag_z(&REG)
+#define FLAG_C()                    flag_c(&REG)
+#define FLAGS_SYNC()                flags_sync(&REG)
+#define FLAGS_ADD(a, b, r)          flags_record(&REG, FLAGS_OP_ADD, a, b, r, 0)
+#define FLAGS_SUB(a, b, r)          flags_record(&REG, FLAGS_OP_SUB, a, b, r, 0)
+#define FLAGS_AND(r)                flags_record(&REG, FLAGS_OP_AND, 0, 0, r, 0)
+#define FLAGS_OR(r)                 flags_record(&REG, FLAGS_OP_OR, 0, 0, r, 0)
+#define FLAGS_INC(r)                flags_record(&REG, FLAGS_OP_INC, 0, 0, r, FLAG_C())
+#define FLAGS_DEC(r)                flags_record(&REG, FLAGS_OP_DEC, 0, 0, r, FLAG_C())
+
+#endif /* INC_GAMEBOY_FLAGS_H_ */
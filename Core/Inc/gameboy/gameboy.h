@@ -0,0 +1,18 @@
+/*
+ * gameboy.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_GAMEBOY_H_
+#define INC_GAMEBOY_GAMEBOY_H_
+
+#include <stdint.h>
+
+// Entry point of the emulator core, ROM buffers are provided by the platform
+// (flash on STM32, files on host) and must stay valid while running
+void gameboy_init(uint8_t *pBootROM, uint8_t *pCartridgeROM, uint32_t CartridgeSize);
+void gameboy_run_frame(void);
+
+#endif /* INC_GAMEBOY_GAMEBOY_H_ */
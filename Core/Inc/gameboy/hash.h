@@ -0,0 +1,105 @@
+/*
+ * hash.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_HASH_H_
+#define INC_GAMEBOY_HASH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// Non-cryptographic hashes to compare emulation runs:
+// - 64-bit FNV-1a, byte per byte, to identify ROM images.
+// - XXH64 with seed 0 computed as data is produced, by stripes of 32 bytes
+//   (a multiple of the size, 32 bytes at least). Input words are read as
+//   little-endian, like the targets.
+
+#define HASH_INIT       0xCBF29CE484222325ULL
+#define HASH_PRIME      0x100000001B3ULL
+
+#define HASH_STRIPE_SIZE    32
+
+#define HASH_XXH_PRIME1     0x9E3779B185EBCA87ULL
+#define HASH_XXH_PRIME2     0xC2B2AE3D27D4EB4FULL
+#define HASH_XXH_PRIME3     0x165667B19E3779F9ULL
+#define HASH_XXH_PRIME4     0x85EBCA77C2B2AE63ULL
+
+struct hash_stream_t
+{
+    uint64_t aAcc[4];
+    uint64_t size;
+};
+
+// Hash is continued from Hash, HASH_INIT to start
+static inline uint64_t hash_update(uint64_t Hash, const void *pData, uint32_t Size)
+{
+    const uint8_t *pByte = pData;
+
+    for (uint32_t i = 0 ; i < Size ; i++)
+        Hash = (Hash ^ pByte[i]) * HASH_PRIME;
+
+    return Hash;
+}
+
+static inline uint64_t hash_rotl(uint64_t Value, int Bits)
+{
+    return (Value << Bits) | (Value >> (64 - Bits));
+}
+
+static inline uint64_t hash_round(uint64_t Acc, uint64_t Input)
+{
+    return hash_rotl(Acc + Input * HASH_XXH_PRIME2, 31) * HASH_XXH_PRIME1;
+}
+
+static inline void hash_stream_init(struct hash_stream_t *pStream)
+{
+    pStream->aAcc[0] = HASH_XXH_PRIME1 + HASH_XXH_PRIME2;
+    pStream->aAcc[1] = HASH_XXH_PRIME2;
+    pStream->aAcc[2] = 0;
+    pStream->aAcc[3] = -HASH_XXH_PRIME1;
+    pStream->size = 0;
+}
+
+// Size is a multiple of HASH_STRIPE_SIZE
+static inline void hash_stream_update(struct hash_stream_t *pStream, const void *pData, uint32_t Size)
+{
+    const uint8_t *pByte = pData;
+
+    for (uint32_t offset = 0 ; offset < Size ; offset += HASH_STRIPE_SIZE)
+    {
+        for (int lane = 0 ; lane < 4 ; lane++)
+        {
+            uint64_t input;
+
+            memcpy(&input, &pByte[offset + lane * 8], 8);
+            pStream->aAcc[lane] = hash_round(pStream->aAcc[lane], input);
+        }
+    }
+
+    pStream->size += Size;
+}
+
+static inline uint64_t hash_stream_digest(const struct hash_stream_t *pStream)
+{
+    uint64_t hash = hash_rotl(pStream->aAcc[0], 1) + hash_rotl(pStream->aAcc[1], 7) +
+                    hash_rotl(pStream->aAcc[2], 12) + hash_rotl(pStream->aAcc[3], 18);
+
+    for (int lane = 0 ; lane < 4 ; lane++)
+        hash = (hash ^ hash_round(0, pStream->aAcc[lane])) * HASH_XXH_PRIME1 + HASH_XXH_PRIME4;
+
+    hash += pStream->size;
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= HASH_XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= HASH_XXH_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+#endif /* INC_GAMEBOY_HASH_H_ */
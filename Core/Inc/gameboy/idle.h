@@ -0,0 +1,53 @@
+/*
+ * idle.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_IDLE_H_
+#define INC_GAMEBOY_IDLE_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Idle loop detection: a short backward JR closing a loop that only reads
+// registers updated by scheduled events (PPU, IF) and writes nothing but A
+// and flags will do the same thing until the next event. Once a whole
+// iteration has run since the last event (loop seen twice in the same
+// cpu_run()), cpu_run() skips whole iterations up to the end of its budget.
+//
+//   loop: LDH A,(44) ; CP 90 ; JR NZ,loop
+
+#define IDLE_LOOP_SIZE_MAX  16  // Bytes from loop head to branch, included
+#define IDLE_LOOP_NB        16  // Loops with statistics
+
+struct idle_loop_t
+{
+    uint16_t pc;        // Loop head
+    uint32_t hits;      // Fast-forwards
+    uint32_t cycles;    // Skipped cycles
+};
+
+struct idle_t
+{
+    bool armed;         // Loop at head seen once in the current cpu_run()
+    uint16_t head;
+    uint8_t loop_counter;
+    struct idle_loop_t aLoop[IDLE_LOOP_NB];
+};
+
+extern GAMEBOY_CONTEXT struct idle_t idle;
+
+// End of cpu_run(): polled registers may change
+static inline void idle_disarm(void)
+{
+    idle.armed = false;
+}
+
+void idle_init(void);
+void idle_check(uint16_t head, uint16_t branch);
+void idle_hit(uint16_t head, uint32_t cycles);
+
+#endif /* INC_GAMEBOY_IDLE_H_ */
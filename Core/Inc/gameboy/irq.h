@@ -8,9 +8,17 @@
 #ifndef INC_GAMEBOY_IRQ_H_
 #define INC_GAMEBOY_IRQ_H_
 
+#include <gameboy/context.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#define IRQ_MASK_VBLANK     0x01
+#define IRQ_MASK_LCDC       0x02
+#define IRQ_MASK_TIMER      0x04
+#define IRQ_MASK_SERIAL     0x08
+#define IRQ_MASK_P10_P13    0x10
+#define IRQ_MASK_ALL        0x1F
+
 struct irq_reg_t
 {
     union
@@ -18,12 +26,12 @@ struct irq_reg_t
         uint8_t Value;
         struct
         {
-            uint8_t : 3;
-            uint8_t P10_P13 : 1;
-            uint8_t Serial : 1;
-            uint8_t Timer : 1;
-            uint8_t LCDC : 1;
             uint8_t VBlank : 1;
+            uint8_t LCDC : 1;
+            uint8_t Timer : 1;
+            uint8_t Serial : 1;
+            uint8_t P10_P13 : 1;
+            uint8_t : 3;
         } Flags;
     };
 };
@@ -35,9 +43,27 @@ struct irq_t
     bool ime; // Interrupt Master Enable
 };
 
-extern struct irq_t irq;
+extern GAMEBOY_CONTEXT struct irq_t irq;
 
 void irq_init(void);
 bool irq_check(void);
 
+// Raise IRQ(s) in IF
+static inline void irq_request(uint8_t mask)
+{
+    irq.pIF->Value |= mask;
+}
+
+// An IRQ is requested and enabled in IE, whatever IME (wakes the CPU from HALT)
+static inline bool irq_requested(void)
+{
+    return (irq.pIE->Value & irq.pIF->Value & IRQ_MASK_ALL) != 0;
+}
+
+// An enabled IRQ is waiting to be serviced
+static inline bool irq_pending(void)
+{
+    return irq.ime && irq_requested();
+}
+
 #endif /* INC_GAMEBOY_IRQ_H_ */
@@ -0,0 +1,37 @@
+/*
+ * joypad.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_JOYPAD_H_
+#define INC_GAMEBOY_JOYPAD_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+
+// Buttons pressed, set by the platform between two frames. P1 (0xFF00)
+// reads them active low for the groups selected by bits 4-5.
+
+#define JOYPAD_RIGHT    0x01
+#define JOYPAD_LEFT     0x02
+#define JOYPAD_UP       0x04
+#define JOYPAD_DOWN     0x08
+#define JOYPAD_A        0x10
+#define JOYPAD_B        0x20
+#define JOYPAD_SELECT   0x40
+#define JOYPAD_START    0x80
+
+struct joypad_t
+{
+    uint8_t *pP1;       // 0xFF00, select bits
+    uint8_t buttons;    // JOYPAD_* pressed
+};
+
+extern GAMEBOY_CONTEXT struct joypad_t joypad;
+
+void joypad_init(void);
+void joypad_set(uint8_t Buttons);
+
+#endif /* INC_GAMEBOY_JOYPAD_H_ */
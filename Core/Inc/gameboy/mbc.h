@@ -0,0 +1,46 @@
+/*
+ * mbc.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_MBC_H_
+#define INC_GAMEBOY_MBC_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Memory Bank Controller of the cartridge, from the header type (0x0147).
+// Writes to 0x0000 - 0x7FFF set its registers, the banks selected are then
+// mapped with mem_map_rom_banks() / mem_map_ram_bank(): a bank switch only
+// updates page table entries.
+
+enum mbc_type_t
+{
+    MBC_NONE = 0,   // ROM only, optional RAM
+    MBC_1,
+    MBC_3,          // RTC registers are not emulated
+    MBC_5,
+};
+
+struct mbc_t
+{
+    enum mbc_type_t type;
+    uint16_t rom_bank_nb;   // Power of 2, clamped to the ROM image
+    uint8_t ram_bank_nb;
+
+    // Registers
+    bool ram_enable;
+    uint16_t bank_low;      // MBC1: 5 bits, MBC3: 7 bits, MBC5: 9 bits
+    uint8_t bank_high;      // MBC1: ROM bits 5-6 or RAM bank, MBC3/5: RAM bank
+    bool mode;              // MBC1: bank_high also applies to 0x0000 & RAM
+};
+
+extern GAMEBOY_CONTEXT struct mbc_t mbc;
+
+void mbc_init(const uint8_t *pCartridgeROM, uint32_t CartridgeSize);
+void mbc_write(uint16_t Addr, uint8_t Value);
+
+#endif /* INC_GAMEBOY_MBC_H_ */
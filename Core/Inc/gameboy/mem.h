@@ -11,6 +11,29 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define MEM_CARTRIDGE_ROM_BANK_MAX      128 // 128 * 16 kiB = 2MiB
+
+// Cartridge RAM banks of 8 kiB. 16 * 8 kiB = 128kiB, the MBC5 maximum. On the
+// F429, 4 * 8 kiB = 32 kiB (every MBC1 and MBC3 game): its 192 kiB of RAM
+// also hold the tile cache, HAL, stack and heap
+#ifndef MEM_CARTRIDGE_RAM_BANK_MAX
+#ifdef STM32F429xx
+#define MEM_CARTRIDGE_RAM_BANK_MAX      4
+#else
+#define MEM_CARTRIDGE_RAM_BANK_MAX      16
+#endif
+#endif
+
+#define MEM_RAM_BANK_NONE               0xFF
+
+// IO Port hooks, Addr in 0xFF00 - 0xFF7F. A write handler stores the value
+// itself, ports without handler are plain storage
+typedef uint8_t (*mem_io_read_t)(uint16_t Addr);
+typedef void (*mem_io_write_t)(uint16_t Addr, uint8_t Value);
+
+// Save states, see gameboy/state.h
+struct state_stream_t;
+
 enum IOPorts_reg
 {
     JOYPAD,
@@ -23,13 +46,19 @@ enum IOPorts_reg
     IE,
 };
 
-void mem_init();
+void mem_init(uint8_t *pBootROM, uint8_t *pCartridgeROM, uint32_t CartridgeSize);
 uint8_t mem_read_u8(uint16_t Addr);
 int8_t mem_read_s8(uint16_t Addr);
 uint16_t mem_read_u16(uint16_t Addr);
 void mem_write_u8(uint16_t Addr, uint8_t Value);
 void mem_write_u16(uint16_t Addr, uint16_t Value);
 uint8_t* mem_get_register(enum IOPorts_reg reg);
+void mem_register_io(uint16_t Addr, mem_io_read_t read, mem_io_write_t write);
+void mem_map_rom_banks(uint16_t Bank0, uint16_t Bank);
+void mem_map_ram_bank(uint8_t Bank);
+void mem_save_state(struct state_stream_t *pStream);
+bool mem_check_state(struct state_stream_t *pStream);
+void mem_load_state(struct state_stream_t *pStream);
 
 uint8_t* mem_get_oam_ram(void);
 uint8_t* mem_get_vram(void);
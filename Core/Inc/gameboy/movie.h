@@ -0,0 +1,65 @@
+/*
+ * movie.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_MOVIE_H_
+#define INC_GAMEBOY_MOVIE_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Input movies: the buttons held on every frame from a save state. Played
+// back on the same ROM, the emulation is the same frame for frame. Buttons
+// are stored as runs of frames, little-endian:
+//
+//   Offset  Size  Field
+//   0       4     MOVIE_MAGIC "GBMV"
+//   4       2     MOVIE_VERSION
+//   6       8     ROM hash, see gameboy/hash.h
+//   14      4     Frames
+//   18      4     Start state size
+//   22      -     Start state, see gameboy/state.h
+//   -       3     Runs: buttons (JOYPAD_*), frames (1 - 65535)
+//
+// Recording: joypad_set(), movie_record_frame() then gameboy_run_frame().
+// Playback: movie_play_frame() then gameboy_run_frame().
+
+#define MOVIE_MAGIC         0x564D4247 // "GBMV"
+#define MOVIE_VERSION       1
+#define MOVIE_HEADER_SIZE   22
+#define MOVIE_RUN_SIZE      3
+#define MOVIE_RUN_MAX       65535
+
+enum movie_mode_t
+{
+    MOVIE_OFF = 0,
+    MOVIE_RECORD,
+    MOVIE_PLAY,
+};
+
+struct movie_t
+{
+    enum movie_mode_t mode;
+    uint8_t *pData;
+    uint32_t size;
+    uint32_t offset;        // Run being recorded or played
+    uint32_t frame_nb;      // Recorded, or to play
+    uint32_t frame;         // Played
+    uint8_t buttons;        // Current run
+    uint16_t run_frames;    // Frames recorded or left in the current run
+};
+
+extern GAMEBOY_CONTEXT struct movie_t movie;
+
+uint64_t movie_rom_hash(const uint8_t *pCartridgeROM, uint32_t CartridgeSize);
+bool movie_record(uint8_t *pBuffer, uint32_t Size, uint64_t ROMHash);
+bool movie_record_frame(void);
+uint32_t movie_stop(void);
+bool movie_play(const uint8_t *pBuffer, uint32_t Size, uint64_t ROMHash);
+bool movie_play_frame(void);
+
+#endif /* INC_GAMEBOY_MOVIE_H_ */
@@ -8,17 +8,33 @@
 #ifndef INC_GAMEBOY_OPCODE_H_
 #define INC_GAMEBOY_OPCODE_H_
 
+#include <gameboy/cpu.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// Opcode dispatch, selected at compile time:
+// - default: indirect call through opcodeList / opcodeCbList on cpu.reg
+// - CPU_DISPATCH_SWITCH: opcode_run() interprets from a switch generated from
+//   the same tables, registers are kept in a local for the duration of a run
+#ifdef CPU_DISPATCH_SWITCH
+#define OPCODE_ARGS     struct cpu_reg_t *pReg __attribute__((unused))
+#define REG             (*pReg)
+#else
+#define OPCODE_ARGS     void
+#define REG             cpu.reg
+#endif
+
 struct opcode_t
 {
-	uint8_t (*func)(void);
+	uint8_t (*func)(OPCODE_ARGS);
 	uint8_t length;
 	bool update_pc;
 };
 
 extern struct opcode_t opcodeList[256];
 
+#ifdef CPU_DISPATCH_SWITCH
+uint32_t opcode_run(uint32_t budget);
+#endif
 
 #endif /* INC_GAMEBOY_OPCODE_H_ */
@@ -12,4 +12,8 @@
 
 extern struct opcode_t opcodeCbList[256];
 
+#ifdef CPU_DISPATCH_SWITCH
+uint8_t opcode_cb_exec(struct cpu_reg_t *pReg, uint8_t opcode);
+#endif
+
 #endif /* INC_GAMEBOY_OPCODE_CB_H_ */
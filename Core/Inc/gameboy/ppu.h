@@ -8,9 +8,62 @@
 #ifndef INC_PPU_H_
 #define INC_PPU_H_
 
+#include <gameboy/context.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <gameboy/hash.h>
 
 #define PPU_OAM_VISIBLE_MAX 10
+#define PPU_FRAME_DURATION  17556 // 154 lines * 114 cycles
+
+#define PPU_SCREEN_WIDTH    160
+#define PPU_SCREEN_HEIGHT   144
+
+#define PPU_FRAME_PERIOD_US 16742   // 70224 / 4194304 Hz, 59.73 Hz
+#define PPU_FRAME_RATE      (4194304.0 / 70224)
+#define PPU_FRAME_SKIP_MAX  4       // Consecutive frames skipped in auto mode
+
+// Shade: 0 (white) - 3 (black), also the PPU_FORMAT_L8 pixel
+typedef uint8_t ppu_pixel_t;
+
+// Called with each line rendered, at the end of pixel transfer. The line is
+// only valid during the call
+typedef void (*ppu_line_sink_t)(uint8_t ly, const ppu_pixel_t *pLine);
+
+// Framebuffer formats, PPU_SCREEN_WIDTH x PPU_SCREEN_HEIGHT without padding
+enum ppu_format_t
+{
+    PPU_FORMAT_L8 = 0,  // 1 byte per pixel, shade as CLUT index
+    PPU_FORMAT_2BPP,    // 4 pixels per byte, leftmost pixel in bits 7-6
+    PPU_FORMAT_RGB565,
+    PPU_FORMAT_ARGB8888,
+
+    PPU_FORMAT_NB
+};
+
+// Default colors of the shades, ARGB8888
+#define PPU_COLOR_WHITE         0xFFFFFFFF
+#define PPU_COLOR_LIGHT_GRAY    0xFFAAAAAA
+#define PPU_COLOR_DARK_GRAY     0xFF555555
+#define PPU_COLOR_BLACK         0xFF000000
+
+// Frames skipped are emulated but not rendered: modes, LY, STAT, IRQs and
+// OAM search are unchanged, only pixels are not composed
+enum ppu_frame_skip_t
+{
+    PPU_FRAME_SKIP_OFF = 0,
+    PPU_FRAME_SKIP_FIXED,   // Render 1 in frame_interval frames
+    PPU_FRAME_SKIP_AUTO,    // Skip frames started late for 59.73 Hz
+};
+
+enum ppu_palette_t
+{
+    PPU_PALETTE_BGP = 0,
+    PPU_PALETTE_OBP0,
+    PPU_PALETTE_OBP1,
+
+    PPU_PALETTE_NB
+};
 
 enum ppu_state_t
 {
@@ -27,14 +80,14 @@ struct ppu_reg_t
         uint8_t LCDC; // LCD Control
         struct
         {
-            uint8_t DisplayEnable : 1;
-            uint8_t WindowTileMapAddr : 1;
-            uint8_t WindowEnable : 1;
-            uint8_t BGWindowTileData : 1;
-            uint8_t BGTileMapAddr : 1;
-            uint8_t OBJSize : 1;
-            uint8_t OBJEnable : 1;
             uint8_t BGEnable : 1;
+            uint8_t OBJEnable : 1;
+            uint8_t OBJSize : 1;
+            uint8_t BGTileMapAddr : 1;
+            uint8_t BGWindowTileData : 1;
+            uint8_t WindowEnable : 1;
+            uint8_t WindowTileMapAddr : 1;
+            uint8_t DisplayEnable : 1;
         } LCDC_Flags;
     };
 
@@ -43,13 +96,13 @@ struct ppu_reg_t
         uint8_t STAT; // LCD Status
         struct
         {
-            uint8_t : 1;
-            uint8_t LYCeqLY : 1;
-            uint8_t Mode2_OAM : 1;
-            uint8_t Mode1_VBlank : 1;
-            uint8_t Mode0_HBlank : 1;
-            uint8_t LYCeqLY_Flag : 1;
             uint8_t ModeFlag : 2;
+            uint8_t LYCeqLY_Flag : 1;
+            uint8_t Mode0_HBlank : 1;   // IRQ enables
+            uint8_t Mode1_VBlank : 1;
+            uint8_t Mode2_OAM : 1;
+            uint8_t LYCeqLY : 1;
+            uint8_t : 1;
         } STAT_Flags;
     };
 
@@ -76,10 +129,51 @@ struct ppu_t
     uint8_t x;
 
     uint8_t OAM_counter;
-    uint8_t aOAM_visible[PPU_OAM_VISIBLE_MAX];
+    uint8_t aOAM_visible[PPU_OAM_VISIBLE_MAX]; // Sorted by drawing priority
+
+    uint8_t window_y; // Window line to render next
+
+    // Palette << 2 | color index to shade, and to pixel in format, rebuilt
+    // on palette register writes. The last palette is the LCD off, white
+    ppu_pixel_t aPalette[(PPU_PALETTE_NB + 1) * 4];
+    uint32_t aPalettePixel[(PPU_PALETTE_NB + 1) * 4];
+
+    // Lines are rendered at the end of pixel transfer, to the framebuffer or
+    // to the line sink. Both NULL: no rendering
+    void *pFramebuffer;
+    ppu_line_sink_t line_sink;
+
+    // Frame skipping, decided when a frame starts
+    enum ppu_frame_skip_t frame_skip;
+    uint8_t frame_interval;
+    uint32_t (*clock_us)(void);     // Real time of PPU_FRAME_SKIP_AUTO
+    uint32_t frame_deadline_us;     // Start of next frame at 59.73 Hz
+    bool skip_frame;                // Current frame not rendered
+    uint8_t skip_counter;           // Consecutive frames skipped
+    uint32_t frame_counter;
+    uint32_t skipped_frame_counter;
+    enum ppu_format_t format;
+    uint32_t aColor[4];     // Shade to ARGB8888, also the L8 CLUT
+    uint32_t aPixel[4];     // Shade to pixel in format
+
+    // XXH64 of the shades of each frame, as lines are rendered
+    bool hash_enable;
+    struct hash_stream_t hash_stream;
+    uint64_t frame_hash;    // Last frame rendered
 };
 
+extern GAMEBOY_CONTEXT struct ppu_t ppu;
+
 void ppu_init(void);
 void ppu_exec(void);
+void ppu_run(uint32_t cycles);
+void ppu_set_framebuffer(void *pFramebuffer, enum ppu_format_t format);
+void ppu_set_line_sink(ppu_line_sink_t line_sink);
+void ppu_set_colors(const uint32_t aColor[4]);
+void ppu_set_frame_skip(enum ppu_frame_skip_t mode, uint8_t interval, uint32_t (*clock_us)(void));
+void ppu_set_frame_hash(bool enable);
+uint32_t ppu_framebuffer_size(enum ppu_format_t format);
+void ppu_update_palette(enum ppu_palette_t palette);
+bool ppu_check_state(uint8_t State, uint8_t Counter, uint8_t Y, uint8_t OAMCounter, const uint8_t *pOAMVisible);
 
 #endif /* INC_PPU_H_ */
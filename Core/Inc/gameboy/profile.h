@@ -0,0 +1,54 @@
+/*
+ * profile.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_PROFILE_H_
+#define INC_GAMEBOY_PROFILE_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+
+// Build with GAMEBOY_PROFILE to track which subsystem is running. A sampling
+// profiler (timer signal on host) reads profile.zone, so entering a zone costs
+// a couple of stores and no timestamp.
+
+enum profile_zone_t
+{
+    PROFILE_OTHER = 0,
+    PROFILE_CPU,
+    PROFILE_MEM,
+    PROFILE_PPU,
+    PROFILE_DMA,
+
+    PROFILE_ZONE_NB
+};
+
+#ifdef GAMEBOY_PROFILE
+
+struct profile_t
+{
+    volatile uint8_t zone;
+    uint32_t instructions;
+    uint32_t dma_transfers;
+};
+
+extern GAMEBOY_CONTEXT struct profile_t profile;
+
+#define PROFILE_ENTER(z)            uint8_t profile_prev = profile.zone; profile.zone = (z)
+#define PROFILE_EXIT()              profile.zone = profile_prev
+#define PROFILE_INSTRUCTION()       profile.instructions++
+#define PROFILE_DMA_TRANSFER()      profile.dma_transfers++
+
+#else
+
+#define PROFILE_ENTER(z)
+#define PROFILE_EXIT()
+#define PROFILE_INSTRUCTION()
+#define PROFILE_DMA_TRANSFER()
+
+#endif
+
+#endif /* INC_GAMEBOY_PROFILE_H_ */
@@ -0,0 +1,55 @@
+/*
+ * rewind.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_REWIND_H_
+#define INC_GAMEBOY_REWIND_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Rewind: a save state every interval frames, in an arena provided by the
+// platform. The newest snapshot is kept as is, each snapshot is stored in a
+// ring as its XOR with the previous one, run-length encoded: most of the
+// memory does not change between two snapshots. Going back loads the newest
+// snapshot and XORs it with its delta to get the previous one. The oldest
+// deltas are dropped when the ring is full.
+//
+// Delta encoding, one control byte then:
+//   0x00 - 0x7F    1 - 128 bytes copied as is
+//   0x80 - 0xFF    1 - 32768 zero bytes, length - 1 on 15 bits with the
+//                  next byte as low byte
+//
+// Each delta is framed by its size on 4 bytes, before and after, so that the
+// ring can be walked from both ends.
+
+#define REWIND_LITERAL_MAX  128
+#define REWIND_ZERO_MAX     32768
+
+struct rewind_ring_t
+{
+    uint8_t *pReference;    // Newest snapshot
+    uint8_t *pScratch;      // Snapshot being captured
+    uint8_t *pRing;
+    uint32_t state_size;
+    uint32_t ring_size;
+    uint32_t head;          // Next delta
+    uint32_t tail;          // Oldest delta
+    uint32_t used;          // Bytes of deltas in the ring
+    uint32_t snapshot_nb;
+    uint8_t interval;       // Frames between snapshots
+    uint8_t frame_counter;
+};
+
+extern GAMEBOY_CONTEXT struct rewind_ring_t rewind_ring;
+
+bool rewind_init(uint8_t *pArena, uint32_t Size, uint8_t Interval);
+void rewind_frame(void);
+bool rewind_back(void);
+uint32_t rewind_footprint(void);
+
+#endif /* INC_GAMEBOY_REWIND_H_ */
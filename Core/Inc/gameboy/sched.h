@@ -0,0 +1,49 @@
+/*
+ * sched.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_SCHED_H_
+#define INC_GAMEBOY_SCHED_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+enum sched_event_id_t
+{
+    SCHED_EVENT_PPU = 0,    // PPU mode change
+    SCHED_EVENT_DMA,        // End of OAM DMA
+    SCHED_EVENT_TIMER,      // TIMA overflow
+
+    SCHED_EVENT_NB
+};
+
+struct sched_event_t
+{
+    void (*func)(void);
+    uint32_t deadline;
+    bool active;
+};
+
+struct sched_t
+{
+    uint8_t next;       // Nearest event, SCHED_EVENT_NB if none
+    uint8_t current;    // Event being serviced, SCHED_EVENT_NB if none
+    uint32_t target;    // End of the cpu_run() in progress
+    uint32_t end;       // End of the last sched_run(), start of the next one
+    struct sched_event_t aEvent[SCHED_EVENT_NB];
+};
+
+extern GAMEBOY_CONTEXT struct sched_t sched;
+
+void sched_init(void);
+void sched_register(enum sched_event_id_t id, void (*func)(void));
+void sched_set(enum sched_event_id_t id, uint32_t delay);
+void sched_set_at(enum sched_event_id_t id, uint32_t deadline);
+void sched_cancel(enum sched_event_id_t id);
+void sched_run(uint32_t cycles);
+
+#endif /* INC_GAMEBOY_SCHED_H_ */
@@ -0,0 +1,93 @@
+/*
+ * state.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_STATE_H_
+#define INC_GAMEBOY_STATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Save states: the emulated machine serialized in a little-endian binary
+// blob, independent of the host and of where the ROM is loaded. Mapped banks
+// are stored as bank numbers. Output settings (framebuffer, line sink, frame
+// skip) are not part of the state, the frame count that fixed frame skip
+// follows is.
+//
+// A state can only be loaded with the cartridge it was saved with (same
+// controller, ROM and RAM sizes), between two gameboy_run_frame().
+//
+//   Offset  Size  Field
+//   0       4     STATE_MAGIC "GBST"
+//   4       2     STATE_VERSION
+//   6       4     Size of the whole state
+//   10      -     Cartridge, CPU, IRQ, joypad, scheduler, timer, PPU, memory
+
+#define STATE_MAGIC     0x54534247 // "GBST"
+#define STATE_VERSION   4
+
+// Cursor over a state buffer, pData NULL only counts the bytes
+struct state_stream_t
+{
+    uint8_t *pData;
+    uint32_t offset;
+};
+
+static inline void state_put_block(struct state_stream_t *pStream, const void *pBlock, uint32_t Size)
+{
+    if (pStream->pData)
+        memcpy(&pStream->pData[pStream->offset], pBlock, Size);
+    pStream->offset += Size;
+}
+
+static inline void state_put_u8(struct state_stream_t *pStream, uint8_t Value)
+{
+    if (pStream->pData)
+        pStream->pData[pStream->offset] = Value;
+    pStream->offset += 1;
+}
+
+static inline void state_put_u16(struct state_stream_t *pStream, uint16_t Value)
+{
+    state_put_u8(pStream, Value & 0xFF);
+    state_put_u8(pStream, Value >> 8);
+}
+
+static inline void state_put_u32(struct state_stream_t *pStream, uint32_t Value)
+{
+    state_put_u16(pStream, Value & 0xFFFF);
+    state_put_u16(pStream, Value >> 16);
+}
+
+static inline void state_get_block(struct state_stream_t *pStream, void *pBlock, uint32_t Size)
+{
+    memcpy(pBlock, &pStream->pData[pStream->offset], Size);
+    pStream->offset += Size;
+}
+
+static inline uint8_t state_get_u8(struct state_stream_t *pStream)
+{
+    return pStream->pData[pStream->offset++];
+}
+
+static inline uint16_t state_get_u16(struct state_stream_t *pStream)
+{
+    uint16_t value = state_get_u8(pStream);
+    return value | (state_get_u8(pStream) << 8);
+}
+
+static inline uint32_t state_get_u32(struct state_stream_t *pStream)
+{
+    uint32_t value = state_get_u16(pStream);
+    return value | ((uint32_t) state_get_u16(pStream) << 16);
+}
+
+uint32_t state_size(void);
+uint32_t state_save(uint8_t *pBuffer, uint32_t Size);
+bool state_load(const uint8_t *pBuffer, uint32_t Size);
+
+#endif /* INC_GAMEBOY_STATE_H_ */
@@ -0,0 +1,73 @@
+/*
+ * tile.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_TILE_H_
+#define INC_GAMEBOY_TILE_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+
+// Cache of the VRAM tile data (0x8000 - 0x97FF) decoded to one color index
+// per pixel. Writes to tile data go through mem_write_u8() slow path and
+// mark the tile row dirty, rows are decoded again when next rendered.
+
+#define TILE_NB         384
+#define TILE_ROW_NB     8
+#define TILE_WIDTH      8
+
+// 2bpp row decoder, selected at compile time unless forced with
+// TILE_DECODER_SCALAR or TILE_DECODER_SWAR. All give the same output as
+// tile_decode_rows_scalar().
+#if defined(TILE_DECODER_SCALAR)
+#define TILE_DECODER_NAME   "scalar"
+#elif defined(TILE_DECODER_SWAR)
+#define TILE_DECODER_NAME   "swar"
+#elif defined(__AVX2__)
+#define TILE_DECODER_AVX2
+#define TILE_DECODER_NAME   "avx2"
+#elif defined(__SSE2__)
+#define TILE_DECODER_SSE2
+#define TILE_DECODER_NAME   "sse2"
+#elif defined(__ARM_NEON)
+#define TILE_DECODER_NEON
+#define TILE_DECODER_NAME   "neon"
+#elif defined(__ARM_FEATURE_DSP)
+#define TILE_DECODER_DSP    // Cortex-M4 SIMD instructions
+#define TILE_DECODER_NAME   "dsp"
+#else
+#define TILE_DECODER_SWAR
+#define TILE_DECODER_NAME   "swar"
+#endif
+
+struct tile_cache_t
+{
+    uint8_t aDirty[TILE_NB]; // One bit per row
+    uint8_t aIndex[TILE_NB][TILE_ROW_NB][TILE_WIDTH]; // Leftmost pixel first
+};
+
+extern GAMEBOY_CONTEXT struct tile_cache_t tile_cache;
+
+void tile_init(void);
+void tile_decode_rows(const uint8_t *pData, uint8_t *pIndex, uint16_t rows);
+void tile_decode_rows_scalar(const uint8_t *pData, uint8_t *pIndex, uint16_t rows);
+void tile_update(uint16_t tile, uint8_t row);
+
+// Offset is relative to 0x8000
+static inline void tile_invalidate(uint16_t Offset)
+{
+    tile_cache.aDirty[Offset >> 4] |= 1 << ((Offset >> 1) & 0x07);
+}
+
+static inline const uint8_t *tile_get_row(uint16_t tile, uint8_t row)
+{
+    if (tile_cache.aDirty[tile] & (1 << row))
+        tile_update(tile, row);
+
+    return tile_cache.aIndex[tile][row];
+}
+
+#endif /* INC_GAMEBOY_TILE_H_ */
@@ -0,0 +1,58 @@
+/*
+ * timer.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_GAMEBOY_TIMER_H_
+#define INC_GAMEBOY_TIMER_H_
+
+#include <gameboy/context.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// DIV & TIMA are not ticked: the divider is the number of cycles since its
+// last reset, and TIMA is brought up to date from the cycles elapsed when it
+// is accessed. Its overflow is the only scheduled event, so a running timer
+// costs one event per overflow.
+//
+// TIMA counts the falling edges of a divider bit, in cycles (1.048576 MHz):
+//
+//   TAC   clock       period  bit
+//   00    4096 Hz     256     7
+//   01    262144 Hz   4       1
+//   10    65536 Hz    16      3
+//   11    16384 Hz    64      5
+
+#define TIMER_DIV_SHIFT     6   // DIV: 16384 Hz
+
+struct timer_reg_t
+{
+    uint8_t DIV;    // Divider, upper 8 bits
+    uint8_t TIMA;   // Timer counter
+    uint8_t TMA;    // Timer modulo, reloaded on overflow
+    union
+    {
+        uint8_t TAC; // Timer control
+        struct
+        {
+            uint8_t Clock : 2;
+            uint8_t Enable : 1;
+            uint8_t : 5;
+        } TAC_Flags;
+    };
+};
+
+struct timer_t
+{
+    struct timer_reg_t *pReg;
+    uint32_t div_base;  // Cycle count at the last DIV reset
+    uint32_t sync;      // Cycle count TIMA is up to date with
+};
+
+extern GAMEBOY_CONTEXT struct timer_t timer;
+
+void timer_init(void);
+
+#endif /* INC_GAMEBOY_TIMER_H_ */
@@ -6,13 +6,16 @@
  */
 
 #include <gameboy/cpu.h>
+#include <gameboy/flags.h>
+#include <gameboy/idle.h>
 #include <gameboy/irq.h>
 #include <gameboy/mem.h>
 #include <gameboy/opcode.h>
 #include <gameboy/opcode_cb.h>
+#include <gameboy/profile.h>
 
 // Exported to be use directly
-struct cpu_t cpu;
+GAMEBOY_CONTEXT struct cpu_t cpu;
 
 void cpu_init(void)
 {
@@ -23,42 +26,178 @@ void cpu_init(void)
     cpu.reg.HL = 0;
     cpu.reg.SP = 0;
     cpu.reg.PC = 0;
+#ifdef CPU_LAZY_FLAGS
+    cpu.reg.Lazy.op = FLAGS_OP_NONE;
+#endif
 
     // Init Flags
-    cpu.halted = false;
+    cpu.mode = CPU_MODE_RUN;
+    cpu.idle_cycles = 0;
     cpu.cycle_counter = 1;
+    cpu.cycles = 0;
+    cpu.prefix_cb = false;
 }
 
-void cpu_exec(void)
+/**
+ * Materialize the F register from the pending lazy flags (no-op otherwise)
+ */
+void cpu_sync_flags(void)
 {
+    flags_sync(&cpu.reg);
+}
+
+/**
+ * Execute one instruction (or IRQ context switch) and return its duration in cycles
+ */
+static uint8_t cpu_step(void)
+{
+#ifdef CPU_DISPATCH_SWITCH
+    return opcode_run(1);
+#else
     bool update_pc = false;
 
+    // Check for interrupt
+    if (false == irq_check())
+    {
+        // Read opcode
+        uint8_t opcode = mem_read_u8(cpu.reg.PC);
+        PROFILE_INSTRUCTION();
+
+        // Execute opcode
+        cpu.cycle_counter = opcodeList[opcode].func();
+        update_pc = opcodeList[opcode].update_pc;
+
+        // Update Program Counter
+        if (update_pc)
+            cpu.reg.PC += opcodeList[opcode].length;
+
+        // CB prefixed opcode is executed in the same step, no IRQ in between
+        if (cpu.prefix_cb)
+        {
+            cpu.prefix_cb = false;
+            opcode = mem_read_u8(cpu.reg.PC + 1);
+            cpu.cycle_counter = opcodeCbList[opcode].func();
+            if (opcodeCbList[opcode].update_pc)
+                cpu.reg.PC += opcodeCbList[opcode].length;
+        }
+    }
+
+    cpu.cycles += cpu.cycle_counter;
+    return cpu.cycle_counter;
+#endif
+}
+
+/**
+ * Execute the instruction following a HALT bug: PC isn't incremented after
+ * the opcode fetch, so the byte after HALT is executed as opcode then read
+ * again. Approximated by stepping back PC once the instruction is executed.
+ */
+static uint8_t cpu_step_halt_bug(void)
+{
+    uint8_t opcode = mem_read_u8(cpu.reg.PC);
+    uint8_t cycles;
+
+    cpu.mode = CPU_MODE_RUN;
+    cycles = cpu_step();
+
+    if ((opcode == 0xCB) || opcodeList[opcode].update_pc)
+        cpu.reg.PC--;
+
+    return cycles;
+}
+
+/**
+ * Skip whole iterations of the idle loop the CPU is in: nothing it polls
+ * changes before the end of the budget
+ */
+static uint32_t cpu_skip_idle_loop(uint32_t budget)
+{
+    uint32_t cycles = budget - budget % cpu.idle_cycles;
+
+    cpu.mode = CPU_MODE_RUN;
+    cpu.cycles += cycles;
+    if (cycles)
+        idle_hit(cpu.reg.PC, cycles);
+
+    return cycles;
+}
+
+/**
+ * Execute instructions until the budget is consumed or the CPU leaves
+ * CPU_MODE_RUN
+ */
+static uint32_t cpu_run_until_halt(uint32_t budget)
+{
+#ifdef CPU_DISPATCH_SWITCH
+    return opcode_run(budget);
+#else
+    uint32_t cycles = 0;
+
+    while ((cycles < budget) && (cpu.mode == CPU_MODE_RUN))
+        cycles += cpu_step();
+
+    return cycles;
+#endif
+}
+
+void cpu_exec(void)
+{
     cpu.cycle_counter--;
 
     if (0 == cpu.cycle_counter)
     {
-        // Check for interrupt
-        if (false == irq_check())
+        cpu.cycle_counter = cpu_run(1);
+    }
+}
+
+uint32_t cpu_run(uint32_t budget)
+{
+    PROFILE_ENTER(PROFILE_CPU);
+    uint32_t cycles = 0;
+
+    while (cycles < budget)
+    {
+        switch (cpu.mode)
         {
-            // Read opcode
-            uint8_t opcode = mem_read_u8(cpu.reg.PC);
-
-            // Execute opcode
-            if (cpu.prefix_cb)
-            {
-                cpu.prefix_cb = false;
-                cpu.cycle_counter = opcodeCbList[opcode].func();
-                update_pc = opcodeCbList[opcode].update_pc;
-            }
-            else
-            {
-                cpu.cycle_counter = opcodeList[opcode].func();
-                update_pc = opcodeList[opcode].update_pc;
-            }
-
-            // Update Program Counter
-            if (update_pc)
-                cpu.reg.PC += opcodeList[opcode].length;
+            case CPU_MODE_HALT:
+                if (!irq_requested())
+                {
+                    // Only an IRQ wakes the CPU up, and IRQs are raised by
+                    // scheduled events: fast-forward to the end of the budget
+                    cpu.cycles += budget - cycles;
+                    cycles = budget;
+                    break;
+                }
+                cpu.mode = CPU_MODE_RUN;
+                break;
+
+            case CPU_MODE_HALT_BUG:
+                cycles += cpu_step_halt_bug();
+                break;
+
+            case CPU_MODE_BREAK:
+                cpu.mode = CPU_MODE_RUN;
+                if (cycles)
+                    budget = cycles;
+                break;
+
+            case CPU_MODE_IDLE_LOOP:
+                cycles += cpu_skip_idle_loop(budget - cycles);
+                // Partial iteration left
+                cycles += cpu_run_until_halt(budget - cycles);
+                break;
+
+            default:
+                cycles += cpu_run_until_halt(budget - cycles);
+                break;
         }
     }
+
+    // Polled registers may change once the budget is over
+    if (cpu.mode == CPU_MODE_IDLE_LOOP)
+        cpu.mode = CPU_MODE_RUN;
+    idle_disarm();
+
+    PROFILE_EXIT();
+    return cycles;
 }
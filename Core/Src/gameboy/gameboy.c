@@ -0,0 +1,69 @@
+/*
+ * gameboy.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/cpu.h>
+#include <gameboy/idle.h>
+#include <gameboy/irq.h>
+#include <gameboy/joypad.h>
+#include <gameboy/mbc.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/profile.h>
+#include <gameboy/sched.h>
+#include <gameboy/tile.h>
+#include <gameboy/timer.h>
+#include <stddef.h>
+
+#ifdef GAMEBOY_PROFILE
+GAMEBOY_CONTEXT struct profile_t profile;
+#endif
+
+/**
+ * State left by the DMG BootROM when it is not run
+ */
+static void skip_boot(void)
+{
+    struct ppu_reg_t *pPPU = (struct ppu_reg_t *) mem_get_register(PPU);
+
+    cpu.reg.AF = 0x01B0;
+    cpu.reg.BC = 0x0013;
+    cpu.reg.DE = 0x00D8;
+    cpu.reg.HL = 0x014D;
+    cpu.reg.SP = 0xFFFE;
+    cpu.reg.PC = 0x0100;
+
+    pPPU->LCDC = 0x91;
+    pPPU->BGP = 0xFC;
+    pPPU->OBP0 = 0xFF;
+    pPPU->OBP1 = 0xFF;
+
+    for (int i = 0 ; i < PPU_PALETTE_NB ; i++)
+        ppu_update_palette(i);
+}
+
+void gameboy_init(uint8_t *pBootROM, uint8_t *pCartridgeROM, uint32_t CartridgeSize)
+{
+    sched_init();
+    cpu_init();
+    idle_init();
+    irq_init();
+    mem_init(pBootROM, pCartridgeROM, CartridgeSize);
+    mbc_init(pCartridgeROM, CartridgeSize);
+    tile_init();
+    ppu_init();
+    timer_init();
+    joypad_init();
+
+    if (NULL == pBootROM)
+        skip_boot();
+}
+
+void gameboy_run_frame(void)
+{
+    sched_run(PPU_FRAME_DURATION);
+}
@@ -0,0 +1,142 @@
+/*
+ * idle.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/idle.h>
+#include <gameboy/cpu.h>
+#include <gameboy/irq.h>
+#include <gameboy/mem.h>
+
+#define IDLE_JR_CYCLES      3
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct idle_t idle;
+
+/**
+ * Registers only changed by scheduled events or by the CPU itself
+ */
+static inline bool is_polled_register(uint16_t Addr)
+{
+    if (Addr == 0xFF0F) // IF
+        return true;
+
+    if ((Addr >= 0xFF40) && (Addr <= 0xFF4B)) // PPU
+        return true;
+
+    return false;
+}
+
+/**
+ * Decode an instruction allowed in an idle loop, return its length or 0.
+ * They only write A and flags, and give the same result when run again.
+ */
+static uint8_t decode(uint16_t pc, uint8_t *pCycles)
+{
+    uint8_t opcode = mem_read_u8(pc);
+
+    switch (opcode)
+    {
+        case 0x00: // NOP
+        case 0xA7: // AND A
+        case 0xB7: // OR A
+        case 0xBF: // CP A
+            *pCycles = 1;
+            return 1;
+
+        case 0xE6: // AND d8
+        case 0xFE: // CP d8
+            *pCycles = 2;
+            return 2;
+
+        case 0xF0: // LDH A,(a8)
+            *pCycles = 3;
+            return is_polled_register(0xFF00 + mem_read_u8(pc + 1)) ? 2 : 0;
+
+        case 0xFA: // LD A,(a16)
+            *pCycles = 4;
+            return is_polled_register(mem_read_u16(pc + 1)) ? 3 : 0;
+
+        case 0xCB: // BIT n,A
+            *pCycles = 2;
+            return ((mem_read_u8(pc + 1) & 0xC7) == 0x47) ? 2 : 0;
+
+        default:
+            return 0;
+    }
+}
+
+void idle_init(void)
+{
+    idle.armed = false;
+    idle.head = 0;
+    idle.loop_counter = 0;
+}
+
+/**
+ * Called on backward JR taken, branch is the address of the JR
+ */
+void idle_check(uint16_t head, uint16_t branch)
+{
+    uint8_t cycles = IDLE_JR_CYCLES;
+    uint16_t pc = head;
+
+    if ((uint16_t) (branch - head) > IDLE_LOOP_SIZE_MAX - 2)
+        return;
+
+    // An IRQ would be serviced on the next instruction
+    if (irq_pending())
+        return;
+
+    while (pc != branch)
+    {
+        uint8_t step;
+        uint8_t length = decode(pc, &step);
+
+        // Not idle, or loop body overlapping the branch
+        if ((length == 0) || ((uint16_t) (branch - pc) < length))
+            return;
+
+        pc += length;
+        cycles += step;
+    }
+
+    // Values polled by the previous iteration may predate the last event,
+    // wait for an iteration run after it
+    if (!idle.armed || (idle.head != head))
+    {
+        idle.armed = true;
+        idle.head = head;
+        return;
+    }
+
+    cpu.mode = CPU_MODE_IDLE_LOOP;
+    cpu.idle_cycles = cycles;
+}
+
+/**
+ * Account for cycles skipped in the loop starting at head
+ */
+void idle_hit(uint16_t head, uint32_t cycles)
+{
+    for (uint8_t i = 0 ; i < idle.loop_counter ; i++)
+    {
+        if (idle.aLoop[i].pc == head)
+        {
+            idle.aLoop[i].hits++;
+            idle.aLoop[i].cycles += cycles;
+            return;
+        }
+    }
+
+    // Loops beyond IDLE_LOOP_NB are not accounted
+    if (idle.loop_counter < IDLE_LOOP_NB)
+    {
+        struct idle_loop_t *pLoop = &idle.aLoop[idle.loop_counter++];
+        pLoop->pc = head;
+        pLoop->hits = 1;
+        pLoop->cycles = cycles;
+    }
+}
@@ -9,12 +9,6 @@
 #include <gameboy/cpu.h>
 #include <gameboy/mem.h>
 
-#define IRQ_MASK_VBLANK     0x01
-#define IRQ_MASK_LCDC       0x02
-#define IRQ_MASK_TIMER      0x04
-#define IRQ_MASK_SERIAL     0x08
-#define IRQ_MASK_P10_P13    0x80
-
 #define IRQ_ADDR_VBLANK     0x40
 #define IRQ_ADDR_LCDC       0x48
 #define IRQ_ADDR_TIMER      0x50
@@ -24,7 +18,7 @@
 #define IRQ_SWITCH_CYCLE    4
 
 // Exported to be use directly
-struct irq_t irq;
+GAMEBOY_CONTEXT struct irq_t irq;
 
 inline static void switch_context(uint8_t Addr)
 {
@@ -46,13 +40,14 @@ bool irq_check(void)
 {
     if (true == irq.ime)
     {
-        uint8_t mask = irq.pIE->Value & irq.pIF->Value;
+        uint8_t mask = irq.pIE->Value & irq.pIF->Value & IRQ_MASK_ALL;
         if (mask)
         {
             // Disable IRQ
             irq.ime = false;
 
-            // TODO HALT
+            // Wake up from HALT
+            cpu.mode = CPU_MODE_RUN;
 
             // Search for active IRQ according to priorities
             if (mask & IRQ_MASK_VBLANK) // V-Blank
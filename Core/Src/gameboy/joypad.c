@@ -0,0 +1,67 @@
+/*
+ * joypad.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/joypad.h>
+#include <gameboy/irq.h>
+#include <gameboy/mem.h>
+
+#define JOYPAD_SELECT_DIRECTIONS    0x10 // Active low
+#define JOYPAD_SELECT_ACTIONS       0x20
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct joypad_t joypad;
+
+/**
+ * Lines P10 - P13 of the selected groups, active low
+ */
+static uint8_t get_lines(void)
+{
+    uint8_t lines = 0;
+
+    if (!(*joypad.pP1 & JOYPAD_SELECT_DIRECTIONS))
+        lines |= joypad.buttons & 0x0F;
+    if (!(*joypad.pP1 & JOYPAD_SELECT_ACTIONS))
+        lines |= joypad.buttons >> 4;
+
+    return ~lines & 0x0F;
+}
+
+static uint8_t io_read_p1(uint16_t Addr)
+{
+    (void) Addr;
+    return 0xC0 | (*joypad.pP1 & 0x30) | get_lines();
+}
+
+/**
+ * P1: only the select bits are writable
+ */
+static void io_write_p1(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    *joypad.pP1 = Value & 0x30;
+}
+
+void joypad_init(void)
+{
+    joypad.pP1 = mem_get_register(JOYPAD);
+    *joypad.pP1 = 0x30;
+    joypad.buttons = 0;
+
+    mem_register_io(0xFF00, io_read_p1, io_write_p1);
+}
+
+/**
+ * Update the buttons pressed, a line going low raises the P10-P13 IRQ
+ */
+void joypad_set(uint8_t Buttons)
+{
+    uint8_t lines = get_lines();
+
+    joypad.buttons = Buttons;
+    if (lines & ~get_lines())
+        irq_request(IRQ_MASK_P10_P13);
+}
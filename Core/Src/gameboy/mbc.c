@@ -0,0 +1,200 @@
+/*
+ * mbc.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/mbc.h>
+#include <gameboy/mem.h>
+#include <stddef.h>
+
+#define MBC_HEADER_TYPE         0x0147
+#define MBC_HEADER_ROM_SIZE     0x0148
+#define MBC_HEADER_RAM_SIZE     0x0149
+
+#define MBC_ROM_BANK_SIZE       16384 // 16 kiB
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct mbc_t mbc;
+
+// ROM banks of header ROM size codes 0x00 - 0x08, 32 kiB << code
+static const uint16_t aROMBankNb[] = {2, 4, 8, 16, 32, 64, 128, 256, 512};
+
+// RAM banks of header RAM size codes, 2 kiB RAM uses the first bytes of a bank
+static const uint8_t aRAMBankNb[] = {0, 1, 1, 4, 16, 8};
+
+static enum mbc_type_t get_type(uint8_t type)
+{
+    switch (type)
+    {
+        case 0x01: // MBC1
+        case 0x02: // MBC1+RAM
+        case 0x03: // MBC1+RAM+BATTERY
+            return MBC_1;
+
+        case 0x0F: // MBC3+TIMER+BATTERY
+        case 0x10: // MBC3+TIMER+RAM+BATTERY
+        case 0x11: // MBC3
+        case 0x12: // MBC3+RAM
+        case 0x13: // MBC3+RAM+BATTERY
+            return MBC_3;
+
+        case 0x19: // MBC5
+        case 0x1A: // MBC5+RAM
+        case 0x1B: // MBC5+RAM+BATTERY
+        case 0x1C: // MBC5+RUMBLE
+        case 0x1D: // MBC5+RUMBLE+RAM
+        case 0x1E: // MBC5+RUMBLE+RAM+BATTERY
+            return MBC_5;
+
+        default: // ROM only, or controller not supported
+            return MBC_NONE;
+    }
+}
+
+/**
+ * ROM banks declared by the header, as many as the image holds if the code
+ * is unknown
+ */
+static uint16_t get_rom_bank_nb(uint8_t code)
+{
+    if (code < sizeof(aROMBankNb) / sizeof(aROMBankNb[0]))
+        return aROMBankNb[code];
+
+    switch (code)
+    {
+        case 0x52: return 72;
+        case 0x53: return 80;
+        case 0x54: return 96;
+        default: return MEM_CARTRIDGE_ROM_BANK_MAX;
+    }
+}
+
+/**
+ * Map the banks selected by the registers
+ */
+static void map_banks(void)
+{
+    uint16_t rom_mask = mbc.rom_bank_nb - 1;
+    uint16_t rom_bank0 = 0;
+    uint16_t rom_bank = mbc.bank_low;
+    uint8_t ram_bank = mbc.bank_high;
+
+    switch (mbc.type)
+    {
+        case MBC_1:
+            // Bank 0 is read as 1, before bits 5-6 are added
+            if (rom_bank == 0)
+                rom_bank = 1;
+
+            rom_bank |= mbc.bank_high << 5;
+            if (mbc.mode)
+                rom_bank0 = mbc.bank_high << 5;
+            else
+                ram_bank = 0;
+            break;
+
+        case MBC_3:
+            if (rom_bank == 0)
+                rom_bank = 1;
+
+            // RTC registers (0x08 - 0x0C) are unmapped
+            if (ram_bank >= 0x08)
+                ram_bank = MEM_RAM_BANK_NONE;
+            break;
+
+        case MBC_5:
+            break;
+
+        default:
+            rom_bank = 1;
+            ram_bank = 0;
+            break;
+    }
+
+    mem_map_rom_banks(rom_bank0 & rom_mask, rom_bank & rom_mask);
+
+    if (mbc.ram_enable && (mbc.ram_bank_nb > 0) && (ram_bank != MEM_RAM_BANK_NONE))
+        mem_map_ram_bank(ram_bank & (mbc.ram_bank_nb - 1));
+    else
+        mem_map_ram_bank(MEM_RAM_BANK_NONE);
+}
+
+void mbc_init(const uint8_t *pCartridgeROM, uint32_t CartridgeSize)
+{
+    // No cartridge, or too short for a header: ROM only without RAM
+    bool header = (pCartridgeROM != NULL) && (CartridgeSize > MBC_HEADER_RAM_SIZE);
+    uint8_t type = header ? pCartridgeROM[MBC_HEADER_TYPE] : 0x00;
+    uint8_t rom_size = header ? pCartridgeROM[MBC_HEADER_ROM_SIZE] : 0x00;
+    uint8_t ram_size = header ? pCartridgeROM[MBC_HEADER_RAM_SIZE] : 0x00;
+
+    mbc.type = get_type(type);
+
+    // Power of 2 for the bank mask, without going past the image
+    mbc.rom_bank_nb = 2;
+    while ((mbc.rom_bank_nb < get_rom_bank_nb(rom_size)) && (mbc.rom_bank_nb < MEM_CARTRIDGE_ROM_BANK_MAX) &&
+           ((mbc.rom_bank_nb * 2) * MBC_ROM_BANK_SIZE <= CartridgeSize))
+        mbc.rom_bank_nb *= 2;
+
+    mbc.ram_bank_nb = (ram_size < sizeof(aRAMBankNb)) ? aRAMBankNb[ram_size] : 0;
+    if (mbc.ram_bank_nb > MEM_CARTRIDGE_RAM_BANK_MAX)
+        mbc.ram_bank_nb = MEM_CARTRIDGE_RAM_BANK_MAX;
+
+    // RAM without controller is always enabled
+    mbc.ram_enable = (mbc.type == MBC_NONE);
+    mbc.bank_low = 1;
+    mbc.bank_high = 0;
+    mbc.mode = false;
+
+    map_banks();
+}
+
+/**
+ * Write to the registers at 0x0000 - 0x7FFF
+ */
+void mbc_write(uint16_t Addr, uint8_t Value)
+{
+    switch (mbc.type)
+    {
+        case MBC_1:
+            if (Addr < 0x2000)
+                mbc.ram_enable = ((Value & 0x0F) == 0x0A);
+            else if (Addr < 0x4000)
+                mbc.bank_low = Value & 0x1F;
+            else if (Addr < 0x6000)
+                mbc.bank_high = Value & 0x03;
+            else
+                mbc.mode = Value & 0x01;
+            break;
+
+        case MBC_3:
+            if (Addr < 0x2000)
+                mbc.ram_enable = ((Value & 0x0F) == 0x0A);
+            else if (Addr < 0x4000)
+                mbc.bank_low = Value & 0x7F;
+            else if (Addr < 0x6000)
+                mbc.bank_high = Value;
+            else // RTC latch
+                return;
+            break;
+
+        case MBC_5:
+            if (Addr < 0x2000)
+                mbc.ram_enable = ((Value & 0x0F) == 0x0A);
+            else if (Addr < 0x3000)
+                mbc.bank_low = (mbc.bank_low & 0x100) | Value;
+            else if (Addr < 0x4000)
+                mbc.bank_low = (mbc.bank_low & 0xFF) | ((Value & 0x01) << 8);
+            else if (Addr < 0x6000)
+                mbc.bank_high = Value & 0x0F;
+            else
+                return;
+            break;
+
+        default:
+            return;
+    }
+
+    map_banks();
+}
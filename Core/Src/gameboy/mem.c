@@ -6,12 +6,18 @@
  */
 
 #include <gameboy/mem.h>
+#include <gameboy/context.h>
+#include <gameboy/mbc.h>
+#include <gameboy/profile.h>
+#include <gameboy/sched.h>
+#include <gameboy/state.h>
+#include <gameboy/tile.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 
-#define MEM_CARTRIDGE_ROM_BANK_MAX      128 // 128 * 16 kiB = 2MiB
-#define MEM_CARTRIDGE_RAM_BANK_MAX      16  // 16 * 8 kiB = 128kiB
+#define MEM_CARTRIDGE_ROM_BANK_SIZE     16384 // 16 kiB
+#define MEM_CARTRIDGE_RAM_BANK_SIZE     8192 // 8 kiB
 
 #define MEM_SRAM_SIZE                   8192 // 8 kiB
 #define MEM_VRAM_SIZE                   8192 // 8 kiB
@@ -19,6 +25,12 @@
 #define MEM_HRAM_SIZE                   128
 #define MEM_IO_PORTS_SIZE               128
 
+#define MEM_DMA_DURATION                160  // 1 byte per cycle
+
+#define MEM_PAGE_SIZE                   256
+#define MEM_PAGE_NB                     256
+#define MEM_ROM_BANK_PAGE_NB            (MEM_CARTRIDGE_ROM_BANK_SIZE / MEM_PAGE_SIZE)
+
 struct memory_map_t
 {
     uint8_t *pBootReg; // BOOT register 0xFF50
@@ -28,9 +40,22 @@ struct memory_map_t
     uint8_t *aCartridgeROMBank[MEM_CARTRIDGE_ROM_BANK_MAX];
 
     // Mapped Banks
+    uint8_t *pMappedROMBank0; // [0x0000 - 0x4000]
     uint8_t *pMappedROMBank; // [0x4000 - 0x8000]
     uint8_t *pMappedRAMBank; // [0xA000 - 0xC000]
 
+    // Their bank numbers, NULL pointers for banks missing from the image
+    uint16_t rom_bank0;
+    uint16_t rom_bank;
+    uint8_t ram_bank;
+
+    // OAM DMA running: only IO Ports & HRAM are accessible
+    bool dma_active;
+
+    // Page tables: one pointer per 256 bytes page, NULL means slow path
+    uint8_t *apReadPage[MEM_PAGE_NB];
+    uint8_t *apWritePage[MEM_PAGE_NB];
+
     // On board RAM
     uint8_t SRAM[MEM_SRAM_SIZE];
     uint8_t VRAM[MEM_VRAM_SIZE];
@@ -38,11 +63,24 @@ struct memory_map_t
     uint8_t HRAM[MEM_HRAM_SIZE];
     uint8_t IOPorts[MEM_IO_PORTS_SIZE];
 
-} mem;
+    // Cartridge RAM
+    uint8_t aCartridgeRAMBank[MEM_CARTRIDGE_RAM_BANK_MAX][MEM_CARTRIDGE_RAM_BANK_SIZE];
+
+};
+
+static GAMEBOY_CONTEXT struct memory_map_t mem;
 
+struct mem_io_port_t
+{
+    mem_io_read_t read;     // NULL: value stored in IOPorts
+    mem_io_write_t write;   // NULL: stored in IOPorts
+};
+
+// IO Ports handlers, set by mem_init() then by the modules owning the ports
+static GAMEBOY_CONTEXT struct mem_io_port_t aIOPort[MEM_IO_PORTS_SIZE];
 
 // IO Ports map
-bool aIOPortsMap[MEM_IO_PORTS_SIZE] =
+static const bool aIOPortsMap[MEM_IO_PORTS_SIZE] =
 {
   //   00     01     02     03     04     05     06     07     08     09     0A     0B     0C     0D     0E     0F
      true,  true,  true, false,  true,  true,  true,  true, false, false, false, false, false, false, false,  true, // 0xFF00
@@ -55,87 +93,406 @@ bool aIOPortsMap[MEM_IO_PORTS_SIZE] =
     false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, // 0xFF70
 };
 
+/**
+ * Map [Start - Start + Size[ on pBase in the page tables
+ */
+static void map_pages(uint16_t Start, uint32_t Size, uint8_t *pBase, bool Writable)
+{
+    uint8_t page = Start / MEM_PAGE_SIZE;
 
-static void* mem_translation(uint16_t Addr)
+    for (uint32_t offset = 0 ; offset < Size ; offset += MEM_PAGE_SIZE, page++)
+    {
+        mem.apReadPage[page] = pBase ? &pBase[offset] : NULL;
+        mem.apWritePage[page] = (pBase && Writable) ? &pBase[offset] : NULL;
+    }
+}
+
+/**
+ * Map the read pages of a ROM bank, ROM is never writable
+ */
+static void map_rom_pages(uint8_t **ppPage, uint8_t *pBank)
 {
-    if ((Addr < 0x100) && (*mem.pBootReg & 0x01))
+    if (NULL == pBank)
     {
-        return &mem.pBootROM[Addr];
+        memset(ppPage, 0, MEM_ROM_BANK_PAGE_NB * sizeof(uint8_t *));
+        return;
     }
 
-	if (Addr < 0x4000) // ROM Bank #0
-		return &mem.aCartridgeROMBank[0][Addr];
+    for (uint32_t i = 0 ; i < MEM_ROM_BANK_PAGE_NB ; i++)
+        ppPage[i] = &pBank[i * MEM_PAGE_SIZE];
+}
+
+/**
+ * BootROM is mapped over ROM Bank #0 until BOOT register is set
+ */
+static void map_bootrom(void)
+{
+    if ((*mem.pBootReg & 0x01) == 0)
+        map_pages(0x0000, 0x0100, mem.pBootROM, false);
+}
+
+/**
+ * OAM DMA: every access below 0xFE00 goes to the slow path
+ */
+static void map_block(void)
+{
+    memset(mem.apReadPage, 0, (0xFE00 / MEM_PAGE_SIZE) * sizeof(uint8_t *));
+    memset(mem.apWritePage, 0, (0xFE00 / MEM_PAGE_SIZE) * sizeof(uint8_t *));
+}
+
+/**
+ * Rebuild the page tables, to be called when BOOT register change
+ */
+static void map_update(void)
+{
+    map_pages(0x0000, 0x4000, mem.pMappedROMBank0, false);         // ROM Bank #0
+    map_pages(0x4000, 0x4000, mem.pMappedROMBank, false);           // Mapped ROM Bank
+    map_pages(0x8000, 0x1800, mem.VRAM, false);                     // VRAM tile data, see tile.h
+    map_pages(0x9800, 0x0800, &mem.VRAM[0x1800], true);             // VRAM tile maps
+    map_pages(0xA000, 0x2000, mem.pMappedRAMBank, true);            // Mapped RAM Bank
+    map_pages(0xC000, 0x2000, mem.SRAM, true);                      // SRAM
+    map_pages(0xE000, 0x1E00, mem.SRAM, true);                      // Echo of SRAM
+
+    // OAM RAM, Empty, IO Ports & HRAM
+    map_pages(0xFE00, 0x0200, NULL, false);
 
-	if (Addr < 0x8000) // Mapped ROM Bank
-		return &mem.pMappedROMBank[Addr - 0x4000];
+    map_bootrom();
 
-	if (Addr < 0xA000) // VRAM
-		return &mem.VRAM[Addr - 0x8000];
+    if (mem.dma_active)
+        map_block();
+}
 
-	if (Addr < 0xC000) // Mapped RAM Bank
-		return &mem.pMappedRAMBank[Addr - 0xA000];
+/**
+ * Unmapped IO Ports hold 0xFF
+ */
+static void io_write_ignore(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    (void) Value;
+}
 
-	if (Addr < 0xE000) // SRAM
-		return &mem.SRAM[Addr - 0xC000];
+/**
+ * BOOT: BootROM unmapped once bit 0 is set
+ */
+static void io_write_boot(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
 
-	if (Addr < 0xFE00) // Echo of SRAM
-		return &mem.SRAM[Addr - 0xE000];
+    if (Value & ~*mem.pBootReg & 0x01)
+    {
+        *mem.pBootReg |= 0x01;
+        map_update();
+    }
+}
 
-	if (Addr < 0xFEA0) // OAM RAM
-		return &mem.OAM_RAM[Addr - 0xFE00];
+/**
+ * End of OAM DMA
+ */
+static void dma_event(void)
+{
+    mem.dma_active = false;
+    map_update();
+}
 
-	if (Addr < 0xFF00) // Empty
-		return NULL;
+/**
+ * DMA: copy of XX00 - XX9F to OAM RAM. Done at once, then the CPU only sees
+ * IO Ports & HRAM for the duration of the transfer
+ */
+static void io_write_dma(uint16_t Addr, uint8_t Value)
+{
+    PROFILE_ENTER(PROFILE_DMA);
+    uint16_t source = Value << 8;
 
-	if (Addr < 0xFF80) // IO Ports
-	{
-	    if (aIOPortsMap[Addr -  0xFF00] == true)
-            return &mem.OAM_RAM[Addr - 0xFF00];
-	    return NULL;
-	}
+    mem.IOPorts[Addr - 0xFF00] = Value;
 
-	return &mem.HRAM[Addr - 0xFF80];
+    // Restarted during a transfer
+    if (mem.dma_active)
+    {
+        mem.dma_active = false;
+        map_update();
+    }
+
+    // Source in a mapped page: bulk copy, otherwise through the slow path
+    const uint8_t *pPage = mem.apReadPage[Value];
+    if (pPage)
+    {
+        memcpy(mem.OAM_RAM, pPage, MEM_OAM_RAM_SIZE);
+    }
+    else
+    {
+        for (uint16_t i = 0 ; i < MEM_OAM_RAM_SIZE ; i++)
+            mem.OAM_RAM[i] = mem_read_u8(source + i);
+    }
+
+    mem.dma_active = true;
+    map_block();
+    sched_set(SCHED_EVENT_DMA, MEM_DMA_DURATION);
+
+    PROFILE_DMA_TRANSFER();
+    PROFILE_EXIT();
 }
 
-void mem_init()
+static uint8_t mem_read_slow(uint16_t Addr)
 {
-    // Init BootROM location
-    mem.pBootROM = (uint8_t *) 0x08100000;
+    if (Addr < 0xFE00) // Unmapped cartridge RAM, or blocked by DMA
+        return 0xFF;
+
+    if (Addr < 0xFEA0) // OAM RAM
+        return mem.dma_active ? 0xFF : mem.OAM_RAM[Addr - 0xFE00];
+
+    if (Addr < 0xFF00) // Empty
+        return 0xFF;
+
+    if (Addr < 0xFF80) // IO Ports
+    {
+        mem_io_read_t read = aIOPort[Addr - 0xFF00].read;
+        return read ? read(Addr) : mem.IOPorts[Addr - 0xFF00];
+    }
+
+    return mem.HRAM[Addr - 0xFF80];
+}
+
+static void mem_write_slow(uint16_t Addr, uint8_t Value)
+{
+    if (mem.dma_active && (Addr < 0xFF00))
+        return;
+
+    if (Addr < 0x8000) // ROM: bank controller
+    {
+        mbc_write(Addr, Value);
+        return;
+    }
+
+    if (Addr < 0x9800) // VRAM tile data
+    {
+        if (mem.VRAM[Addr - 0x8000] != Value)
+        {
+            mem.VRAM[Addr - 0x8000] = Value;
+            tile_invalidate(Addr - 0x8000);
+        }
+        return;
+    }
+
+    if (Addr < 0xFE00) // Unmapped cartridge RAM
+        return;
+
+    if (Addr < 0xFEA0) // OAM RAM
+    {
+        mem.OAM_RAM[Addr - 0xFE00] = Value;
+        return;
+    }
+
+    if (Addr < 0xFF00) // Empty
+        return;
+
+    if (Addr < 0xFF80) // IO Ports
+    {
+        mem_io_write_t write = aIOPort[Addr - 0xFF00].write;
+        if (write)
+            write(Addr, Value);
+        else
+            mem.IOPorts[Addr - 0xFF00] = Value;
+        return;
+    }
+
+    mem.HRAM[Addr - 0xFF80] = Value;
+}
+
+void mem_init(uint8_t *pBootROM, uint8_t *pCartridgeROM, uint32_t CartridgeSize)
+{
+    // RAM cleared as on first power on, the previous cartridge is not seen
+    // when initialized again. IF and IE are cleared by irq_init() anyway
+    memset(mem.SRAM, 0, sizeof(mem.SRAM));
+    memset(mem.VRAM, 0, sizeof(mem.VRAM));
+    memset(mem.OAM_RAM, 0, sizeof(mem.OAM_RAM));
+    memset(mem.HRAM, 0, sizeof(mem.HRAM));
+    memset(mem.IOPorts, 0, sizeof(mem.IOPorts));
+    memset(mem.aCartridgeRAMBank, 0, sizeof(mem.aCartridgeRAMBank));
+
+    // Init BootROM location, skipped if not provided
+    mem.pBootROM = pBootROM;
     mem.pBootReg = mem_get_register(BOOT);
+    *mem.pBootReg = pBootROM ? 0x00 : 0x01;
+
+    // IO Ports: plain storage, unmapped ones read as 0xFF
+    for (uint8_t port = 0 ; port < MEM_IO_PORTS_SIZE ; port++)
+    {
+        aIOPort[port].read = NULL;
+        aIOPort[port].write = aIOPortsMap[port] ? NULL : io_write_ignore;
+        if (!aIOPortsMap[port])
+            mem.IOPorts[port] = 0xFF;
+    }
+    mem_register_io(0xFF46, NULL, io_write_dma);
+    mem_register_io(0xFF50, NULL, io_write_boot);
+    sched_register(SCHED_EVENT_DMA, dma_event);
+    mem.dma_active = false;
 
     // Init Cartridge ROM banks location
     memset(mem.aCartridgeROMBank, 0, MEM_CARTRIDGE_ROM_BANK_MAX * sizeof(uint8_t *));
-    mem.aCartridgeROMBank[0] = (uint8_t *) 0x08110000;
-    mem.aCartridgeROMBank[1] = (uint8_t *) 0x08118000;
+    for (uint32_t i = 0 ; (i < MEM_CARTRIDGE_ROM_BANK_MAX) && (i * MEM_CARTRIDGE_ROM_BANK_SIZE < CartridgeSize) ; i++)
+        mem.aCartridgeROMBank[i] = &pCartridgeROM[i * MEM_CARTRIDGE_ROM_BANK_SIZE];
 
-    // Map memory
+    // Map memory, banks are then selected by mbc_init()
+    mem.pMappedROMBank0 = mem.aCartridgeROMBank[0];
     mem.pMappedROMBank = mem.aCartridgeROMBank[1];
     mem.pMappedRAMBank = NULL;
+    mem.rom_bank0 = 0;
+    mem.rom_bank = 1;
+    mem.ram_bank = MEM_RAM_BANK_NONE;
+    map_update();
+}
+
+/**
+ * Map ROM banks at 0x0000 and 0x4000, only the page tables of the banks
+ * changed are updated
+ */
+void mem_map_rom_banks(uint16_t Bank0, uint16_t Bank)
+{
+    uint8_t *pBank0 = mem.aCartridgeROMBank[Bank0];
+    uint8_t *pBank = mem.aCartridgeROMBank[Bank];
+
+    mem.rom_bank0 = Bank0;
+    mem.rom_bank = Bank;
+
+    // ROM write pages stay unmapped
+    if (pBank0 != mem.pMappedROMBank0)
+    {
+        mem.pMappedROMBank0 = pBank0;
+        map_rom_pages(&mem.apReadPage[0x00], pBank0);
+        map_bootrom();
+    }
+
+    if (pBank != mem.pMappedROMBank)
+    {
+        mem.pMappedROMBank = pBank;
+        map_rom_pages(&mem.apReadPage[0x4000 / MEM_PAGE_SIZE], pBank);
+    }
+}
+
+/**
+ * Map a cartridge RAM bank at 0xA000, MEM_RAM_BANK_NONE: disabled
+ */
+void mem_map_ram_bank(uint8_t Bank)
+{
+    uint8_t *pBank = (Bank == MEM_RAM_BANK_NONE) ? NULL : mem.aCartridgeRAMBank[Bank];
+
+    mem.ram_bank = Bank;
+    if (pBank != mem.pMappedRAMBank)
+    {
+        mem.pMappedRAMBank = pBank;
+        map_pages(0xA000, 0x2000, pBank, true);
+    }
+}
+
+/**
+ * Mapped banks as bank numbers, then on board and cartridge RAM
+ */
+void mem_save_state(struct state_stream_t *pStream)
+{
+    state_put_u16(pStream, mem.rom_bank0);
+    state_put_u16(pStream, mem.rom_bank);
+    state_put_u8(pStream, mem.ram_bank);
+    state_put_u8(pStream, mem.dma_active);
+
+    state_put_block(pStream, mem.SRAM, MEM_SRAM_SIZE);
+    state_put_block(pStream, mem.VRAM, MEM_VRAM_SIZE);
+    state_put_block(pStream, mem.OAM_RAM, MEM_OAM_RAM_SIZE);
+    state_put_block(pStream, mem.HRAM, MEM_HRAM_SIZE);
+    state_put_block(pStream, mem.IOPorts, MEM_IO_PORTS_SIZE);
+    state_put_block(pStream, mem.aCartridgeRAMBank, mbc.ram_bank_nb * MEM_CARTRIDGE_RAM_BANK_SIZE);
+}
+
+/**
+ * Same layout as mem_load_state(): mapped banks among those of the cartridge,
+ * the RAM banks restored are the mbc.ram_bank_nb first ones
+ */
+bool mem_check_state(struct state_stream_t *pStream)
+{
+    uint16_t rom_bank0 = state_get_u16(pStream);
+    uint16_t rom_bank = state_get_u16(pStream);
+    uint8_t ram_bank = state_get_u8(pStream);
+
+    return (rom_bank0 < mbc.rom_bank_nb) && (rom_bank < mbc.rom_bank_nb) &&
+           ((ram_bank == MEM_RAM_BANK_NONE) || (ram_bank < mbc.ram_bank_nb));
+}
+
+/**
+ * Counterpart of mem_save_state(), for the same cartridge, checked by
+ * mem_check_state(). The tile cache must be invalidated
+ */
+void mem_load_state(struct state_stream_t *pStream)
+{
+    mem.rom_bank0 = state_get_u16(pStream);
+    mem.rom_bank = state_get_u16(pStream);
+    mem.ram_bank = state_get_u8(pStream);
+
+    mem.pMappedROMBank0 = mem.aCartridgeROMBank[mem.rom_bank0];
+    mem.pMappedROMBank = mem.aCartridgeROMBank[mem.rom_bank];
+    mem.pMappedRAMBank = (mem.ram_bank == MEM_RAM_BANK_NONE) ? NULL : mem.aCartridgeRAMBank[mem.ram_bank];
+    mem.dma_active = state_get_u8(pStream);
+
+    state_get_block(pStream, mem.SRAM, MEM_SRAM_SIZE);
+    state_get_block(pStream, mem.VRAM, MEM_VRAM_SIZE);
+    state_get_block(pStream, mem.OAM_RAM, MEM_OAM_RAM_SIZE);
+    state_get_block(pStream, mem.HRAM, MEM_HRAM_SIZE);
+    state_get_block(pStream, mem.IOPorts, MEM_IO_PORTS_SIZE);
+    state_get_block(pStream, mem.aCartridgeRAMBank, mbc.ram_bank_nb * MEM_CARTRIDGE_RAM_BANK_SIZE);
+
+    map_update();
 }
 
 uint8_t mem_read_u8(uint16_t Addr)
 {
-	return *((uint8_t *) mem_translation(Addr));
+    PROFILE_ENTER(PROFILE_MEM);
+    uint8_t *pPage = mem.apReadPage[Addr >> 8];
+    uint8_t value;
+
+    if (pPage)
+        value = pPage[Addr & 0xFF];
+    else
+        value = mem_read_slow(Addr);
+
+    PROFILE_EXIT();
+    return value;
 }
 
 int8_t mem_read_s8(uint16_t Addr)
 {
-	return *((int8_t *) mem_translation(Addr));
+    return (int8_t) mem_read_u8(Addr);
 }
 
 uint16_t mem_read_u16(uint16_t Addr)
 {
-	return *((uint16_t *) mem_translation(Addr));
+    return mem_read_u8(Addr) | (mem_read_u8(Addr + 1) << 8);
 }
 
 void mem_write_u8(uint16_t Addr, uint8_t Value)
 {
-	*((uint8_t *) mem_translation(Addr)) = Value;
+    PROFILE_ENTER(PROFILE_MEM);
+    uint8_t *pPage = mem.apWritePage[Addr >> 8];
+
+    if (pPage)
+        pPage[Addr & 0xFF] = Value;
+    else
+        mem_write_slow(Addr, Value);
+
+    PROFILE_EXIT();
 }
 
 void mem_write_u16(uint16_t Addr, uint16_t Value)
 {
-	*((uint16_t *) mem_translation(Addr)) = Value;
+    mem_write_u8(Addr, Value & 0xFF);
+    mem_write_u8(Addr + 1, Value >> 8);
+}
+
+/**
+ * Set the handlers of an IO Port, NULL: plain storage. Handlers are reset by
+ * mem_init()
+ */
+void mem_register_io(uint16_t Addr, mem_io_read_t read, mem_io_write_t write)
+{
+    aIOPort[Addr - 0xFF00].read = read;
+    aIOPort[Addr - 0xFF00].write = write;
 }
 
 uint8_t* mem_get_register(enum IOPorts_reg reg)
@@ -155,7 +512,7 @@ uint8_t* mem_get_register(enum IOPorts_reg reg)
         case IF:
             return &mem.IOPorts[0x0F];
         case IE:
-            return &mem.IOPorts[0xFF];
+            return &mem.HRAM[0x7F];
         case BOOT:
             return &mem.IOPorts[0x50];
         default:
@@ -0,0 +1,178 @@
+/*
+ * movie.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/movie.h>
+#include <gameboy/hash.h>
+#include <gameboy/joypad.h>
+#include <gameboy/mbc.h>
+#include <gameboy/state.h>
+
+#define MOVIE_FRAME_NB_OFFSET   14
+#define MOVIE_ROM_BANK_SIZE     16384 // 16 kiB
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct movie_t movie;
+
+/**
+ * Hash of the ROM banks used by the controller, the image may be padded
+ */
+uint64_t movie_rom_hash(const uint8_t *pCartridgeROM, uint32_t CartridgeSize)
+{
+    uint32_t size = mbc.rom_bank_nb * MOVIE_ROM_BANK_SIZE;
+
+    if (size > CartridgeSize)
+        size = CartridgeSize;
+
+    return hash_update(HASH_INIT, pCartridgeROM, size);
+}
+
+static void put_run(void)
+{
+    struct state_stream_t stream = {movie.pData, movie.offset};
+
+    state_put_u8(&stream, movie.buttons);
+    state_put_u16(&stream, movie.run_frames);
+    movie.offset = stream.offset;
+}
+
+/**
+ * Start recording from the current state, to be called between two frames.
+ * False if pBuffer can't hold the state
+ */
+bool movie_record(uint8_t *pBuffer, uint32_t Size, uint64_t ROMHash)
+{
+    struct state_stream_t stream = {pBuffer, 0};
+    uint32_t size = state_size();
+
+    if (Size < MOVIE_HEADER_SIZE + size + MOVIE_RUN_SIZE)
+        return false;
+
+    state_put_u32(&stream, MOVIE_MAGIC);
+    state_put_u16(&stream, MOVIE_VERSION);
+    state_put_u32(&stream, ROMHash & 0xFFFFFFFF);
+    state_put_u32(&stream, ROMHash >> 32);
+    state_put_u32(&stream, 0);
+    state_put_u32(&stream, size);
+    state_save(&pBuffer[stream.offset], size);
+
+    movie.mode = MOVIE_RECORD;
+    movie.pData = pBuffer;
+    movie.size = Size;
+    movie.offset = MOVIE_HEADER_SIZE + size;
+    movie.frame_nb = 0;
+    movie.frame = 0;
+    movie.run_frames = 0;
+
+    return true;
+}
+
+/**
+ * Record the buttons of the next frame, false once the buffer is full. The
+ * current run always has room left
+ */
+bool movie_record_frame(void)
+{
+    if (movie.mode != MOVIE_RECORD)
+        return false;
+
+    if ((movie.run_frames == 0) || (movie.buttons != joypad.buttons) || (movie.run_frames == MOVIE_RUN_MAX))
+    {
+        if ((movie.run_frames != 0) && (movie.offset + 2 * MOVIE_RUN_SIZE > movie.size))
+            return false;
+
+        if (movie.run_frames != 0)
+            put_run();
+        movie.buttons = joypad.buttons;
+        movie.run_frames = 0;
+    }
+
+    movie.run_frames++;
+    movie.frame_nb++;
+    return true;
+}
+
+/**
+ * End recording or playback, return the size of the movie recorded
+ */
+uint32_t movie_stop(void)
+{
+    enum movie_mode_t mode = movie.mode;
+
+    movie.mode = MOVIE_OFF;
+    if (mode != MOVIE_RECORD)
+        return 0;
+
+    if (movie.run_frames != 0)
+        put_run();
+
+    struct state_stream_t stream = {movie.pData, MOVIE_FRAME_NB_OFFSET};
+    state_put_u32(&stream, movie.frame_nb);
+
+    return movie.offset;
+}
+
+/**
+ * Load the start state of a movie recorded on the ROM hashed, false if it
+ * is not one
+ */
+bool movie_play(const uint8_t *pBuffer, uint32_t Size, uint64_t ROMHash)
+{
+    // Only read
+    struct state_stream_t stream = {(uint8_t *) pBuffer, 0};
+
+    if (Size < MOVIE_HEADER_SIZE)
+        return false;
+
+    if ((state_get_u32(&stream) != MOVIE_MAGIC) || (state_get_u16(&stream) != MOVIE_VERSION))
+        return false;
+
+    uint64_t hash = state_get_u32(&stream);
+    hash |= (uint64_t) state_get_u32(&stream) << 32;
+    uint32_t frame_nb = state_get_u32(&stream);
+    uint32_t size = state_get_u32(&stream);
+
+    if ((hash != ROMHash) || (size > Size - MOVIE_HEADER_SIZE) || !state_load(&pBuffer[MOVIE_HEADER_SIZE], size))
+        return false;
+
+    movie.mode = MOVIE_PLAY;
+    movie.pData = (uint8_t *) pBuffer;
+    movie.size = Size;
+    movie.offset = MOVIE_HEADER_SIZE + size;
+    movie.frame_nb = frame_nb;
+    movie.frame = 0;
+    movie.run_frames = 0;
+
+    return true;
+}
+
+/**
+ * Set the buttons of the next frame, false at the end of the movie
+ */
+bool movie_play_frame(void)
+{
+    if ((movie.mode != MOVIE_PLAY) || (movie.frame == movie.frame_nb))
+        return false;
+
+    if (movie.run_frames == 0)
+    {
+        struct state_stream_t stream = {movie.pData, movie.offset};
+
+        if (movie.offset + MOVIE_RUN_SIZE > movie.size)
+            return false;
+
+        movie.buttons = state_get_u8(&stream);
+        movie.run_frames = state_get_u16(&stream);
+        movie.offset = stream.offset;
+        if (movie.run_frames == 0)
+            return false;
+    }
+
+    joypad_set(movie.buttons);
+    movie.run_frames--;
+    movie.frame++;
+    return true;
+}
@@ -6,10 +6,13 @@
  */
 
 #include <gameboy/cpu.h>
+#include <gameboy/flags.h>
+#include <gameboy/idle.h>
 #include <gameboy/irq.h>
 #include <gameboy/mem.h>
 #include <gameboy/opcode.h>
 #include <gameboy/opcode_cb.h>
+#include <gameboy/profile.h>
 #include <stdio.h>
 
 //////////////////////
@@ -18,9 +21,9 @@
 
 // Macro: LD r1, r2
 #define MACRO_LD_r1_r2(r1, r2) \
-static uint8_t LD_##r1##_##r2(void) \
+static uint8_t LD_##r1##_##r2(OPCODE_ARGS) \
 { \
-    cpu.reg.r1 = cpu.reg.r2; \
+    REG.r1 = REG.r2; \
     return 1; \
 }
 
@@ -84,9 +87,9 @@ MACRO_LD_r1_r2(A, A);    // LD A, A
 
 // Macro: LD r1, (HL)
 #define MACRO_LD_r1_HL(r1) \
-static uint8_t LD_##r1##_HL(void) \
+static uint8_t LD_##r1##_HL(OPCODE_ARGS) \
 { \
-    cpu.reg.r1 = mem_read_u8(cpu.reg.HL); \
+    REG.r1 = mem_read_u8(REG.HL); \
     return 2; \
 }
 
@@ -102,9 +105,9 @@ MACRO_LD_r1_HL(A);        // LD A, (HL)
 
 // Macro: LD (HL), r1
 #define MACRO_LD_HL_r1(r1) \
-static uint8_t LD_HL_##r1(void) \
+static uint8_t LD_HL_##r1(OPCODE_ARGS) \
 { \
-    mem_write_u8(cpu.reg.HL, cpu.reg.r1); \
+    mem_write_u8(REG.HL, REG.r1); \
     return 2; \
 }
 
@@ -120,9 +123,9 @@ MACRO_LD_HL_r1(A);        // LD (HL), A
 
 // Macro: LD (HL), r1
 #define MACRO_LD_r1_d8(r1) \
-static uint8_t LD_##r1##_d8(void) \
+static uint8_t LD_##r1##_d8(OPCODE_ARGS) \
 { \
-    cpu.reg.r1 = mem_read_u8(cpu.reg.PC + 1); \
+    REG.r1 = mem_read_u8(REG.PC + 1); \
     return 2; \
 }
 
@@ -137,17 +140,17 @@ MACRO_LD_r1_d8(A);        // LD A, d8
 #undef MACRO_LD_r1_d8
 
 // LD (HL), d8
-static uint8_t LD_HL_d8(void)
+static uint8_t LD_HL_d8(OPCODE_ARGS)
 {
-    mem_write_u8(cpu.reg.HL, mem_read_u8(cpu.reg.PC + 1));
+    mem_write_u8(REG.HL, mem_read_u8(REG.PC + 1));
     return 3;
 }
 
 // Macro: LD (r1), A
 #define MACRO_LD_r1_A(r1) \
-static uint8_t LD_##r1##_A(void) \
+static uint8_t LD_##r1##_A(OPCODE_ARGS) \
 { \
-    mem_write_u8(cpu.reg.r1, cpu.reg.A); \
+    mem_write_u8(REG.r1, REG.A); \
     return 2; \
 }
 
@@ -157,24 +160,24 @@ MACRO_LD_r1_A(DE);        // LD (DE), A
 #undef MACRO_LD_r1_A
 
 // LD (HL+), A
-static uint8_t LD_HLp_A(void)
+static uint8_t LD_HLp_A(OPCODE_ARGS)
 {
-    mem_write_u8(cpu.reg.HL++, cpu.reg.A);
+    mem_write_u8(REG.HL++, REG.A);
     return 2;
 }
 
 // LD (HL-), A
-static uint8_t LD_HLm_A(void)
+static uint8_t LD_HLm_A(OPCODE_ARGS)
 {
-    mem_write_u8(cpu.reg.HL--, cpu.reg.A);
+    mem_write_u8(REG.HL--, REG.A);
     return 2;
 }
 
 // Macro: LD (r1), A
 #define MACRO_LD_A_r1(r1) \
-static uint8_t LD_A_##r1(void) \
+static uint8_t LD_A_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.A = mem_read_u8(cpu.reg.r1); \
+    REG.A = mem_read_u8(REG.r1); \
     return 2; \
 }
 
@@ -184,62 +187,62 @@ MACRO_LD_A_r1(DE);        // LD A, (DE)
 #undef MACRO_LD_A_r1
 
 // LD A, (HL+)
-static uint8_t LD_A_HLp(void)
+static uint8_t LD_A_HLp(OPCODE_ARGS)
 {
-    cpu.reg.A = mem_read_u8(cpu.reg.HL++);
+    REG.A = mem_read_u8(REG.HL++);
     return 2;
 }
 
 // LD A, (HL-)
-static uint8_t LD_A_HLm(void)
+static uint8_t LD_A_HLm(OPCODE_ARGS)
 {
-    cpu.reg.A = mem_read_u8(cpu.reg.HL--);
+    REG.A = mem_read_u8(REG.HL--);
     return 2;
 }
 
 // LDH (a8), A
-static uint8_t LDH_a8_A(void)
+static uint8_t LDH_a8_A(OPCODE_ARGS)
 {
-    uint8_t a8 = mem_read_u8(cpu.reg.PC + 1);
-    mem_write_u8(0xFF00 + a8, cpu.reg.A);
+    uint8_t a8 = mem_read_u8(REG.PC + 1);
+    mem_write_u8(0xFF00 + a8, REG.A);
     return 3;
 }
 
 // LDH A, (a8)
-static uint8_t LDH_A_a8(void)
+static uint8_t LDH_A_a8(OPCODE_ARGS)
 {
-    uint8_t a8 = mem_read_u8(cpu.reg.PC + 1);
-    cpu.reg.A = mem_read_u8(0xFF00 + a8);
+    uint8_t a8 = mem_read_u8(REG.PC + 1);
+    REG.A = mem_read_u8(0xFF00 + a8);
     return 3;
 }
 
 // LD (C), A
-static uint8_t LD_pC_A(void)
+static uint8_t LD_pC_A(OPCODE_ARGS)
 {
-    mem_write_u8(0xFF00 + cpu.reg.C, cpu.reg.A);
+    mem_write_u8(0xFF00 + REG.C, REG.A);
     return 2;
 }
 
 // LD A, (C)
-static uint8_t LD_A_pC(void)
+static uint8_t LD_A_pC(OPCODE_ARGS)
 {
-    cpu.reg.A = mem_read_u8(0xFF00 + cpu.reg.C);
+    REG.A = mem_read_u8(0xFF00 + REG.C);
     return 2;
 }
 
 // LD (a16), A
-static uint8_t LD_a16_A(void)
+static uint8_t LD_a16_A(OPCODE_ARGS)
 {
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1);
-    mem_write_u8(a16, cpu.reg.A);
+    uint16_t a16 = mem_read_u16(REG.PC + 1);
+    mem_write_u8(a16, REG.A);
     return 4;
 }
 
 // LD A, (a16)
-static uint8_t LD_A_a16(void)
+static uint8_t LD_A_a16(OPCODE_ARGS)
 {
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1);
-    cpu.reg.A = mem_read_u8(a16);
+    uint16_t a16 = mem_read_u16(REG.PC + 1);
+    REG.A = mem_read_u8(a16);
     return 4;
 }
 
@@ -249,9 +252,9 @@ static uint8_t LD_A_a16(void)
 
 // Macro: LD r1, d16
 #define MACRO_LD_r1_d16(r1) \
-static uint8_t LD_##r1##_d16(void) \
+static uint8_t LD_##r1##_d16(OPCODE_ARGS) \
 { \
-    cpu.reg.r1 = mem_read_u16(cpu.reg.PC + 1); \
+    REG.r1 = mem_read_u16(REG.PC + 1); \
     return 3; \
 }
 
@@ -263,83 +266,97 @@ MACRO_LD_r1_d16(SP);        // LD SP, d16
 #undef MACRO_LD_r1_d16
 
 // LD (a16), SP
-static uint8_t LD_a16_SP(void)
+static uint8_t LD_a16_SP(OPCODE_ARGS)
 {
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1);
+    uint16_t a16 = mem_read_u16(REG.PC + 1);
 
-    mem_write_u16(a16, cpu.reg.SP);
+    mem_write_u16(a16, REG.SP);
     return 5;
 }
 
 // LD HL, SP+r8
-static uint8_t LD_HL_SP_r8(void)
+static uint8_t LD_HL_SP_r8(OPCODE_ARGS)
 {
-    int8_t r8 = mem_read_s8(cpu.reg.PC + 1);
+    FLAGS_SYNC();
+    int8_t r8 = mem_read_s8(REG.PC + 1);
 
-    cpu.reg.HL = cpu.reg.SP + r8;
-    cpu.reg.F = 0;
-    if ((cpu.reg.SP & 0x0F) + (r8 & 0x0F) > 0x0F)
-        cpu.reg.Flags.H = 1;
+    REG.HL = REG.SP + r8;
+    REG.F = 0;
+    if ((REG.SP & 0x0F) + (r8 & 0x0F) > 0x0F)
+        REG.Flags.H = 1;
 
-    if ((cpu.reg.SP & 0xFF) + ((uint16_t) r8 & 0xFF) > 0xFF)
-        cpu.reg.Flags.C = 1;
+    if ((REG.SP & 0xFF) + ((uint16_t) r8 & 0xFF) > 0xFF)
+        REG.Flags.C = 1;
 
     return 3;
 }
 
 // LD SP, HL
-static uint8_t LD_SP_HL(void)
+static uint8_t LD_SP_HL(OPCODE_ARGS)
 {
-    cpu.reg.SP = cpu.reg.HL;
+    REG.SP = REG.HL;
     return 2;
 }
 
 // Macro: PUSH r1
 #define MACRO_PUSH_r1(r1) \
-static uint8_t PUSH_##r1(void) \
+static uint8_t PUSH_##r1(OPCODE_ARGS) \
 { \
-    mem_write_u16(cpu.reg.SP - 2, cpu.reg.r1); \
-    cpu.reg.SP -= 2; \
+    mem_write_u16(REG.SP - 2, REG.r1); \
+    REG.SP -= 2; \
     return 4; \
 }
 
 MACRO_PUSH_r1(BC);     // PUSH BC
 MACRO_PUSH_r1(DE);     // PUSH DE
 MACRO_PUSH_r1(HL);     // PUSH HL
-MACRO_PUSH_r1(AF);     // PUSH AF
 
 #undef MACRO_PUSH_r1
 
+// PUSH AF
+static uint8_t PUSH_AF(OPCODE_ARGS)
+{
+    FLAGS_SYNC();
+    mem_write_u16(REG.SP - 2, REG.AF);
+    REG.SP -= 2;
+    return 4;
+}
+
 // Macro: POP r1
 #define MACRO_POP_r1(r1) \
-static uint8_t POP_##r1(void) \
+static uint8_t POP_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.r1 = mem_read_u16(cpu.reg.SP); \
-    cpu.reg.SP += 2; \
+    REG.r1 = mem_read_u16(REG.SP); \
+    REG.SP += 2; \
     return 3; \
 }
 
 MACRO_POP_r1(BC);     // POP BC
 MACRO_POP_r1(DE);     // POP DE
 MACRO_POP_r1(HL);     // POP HL
-MACRO_POP_r1(AF);     // POP AF
 
 #undef MACRO_POP_r1
 
+// POP AF
+static uint8_t POP_AF(OPCODE_ARGS)
+{
+    FLAGS_SYNC();
+    REG.AF = mem_read_u16(REG.SP) & 0xFFF0; // Lower bits of F are always 0
+    REG.SP += 2;
+    return 3;
+}
+
 //////////////////////
 // Arithmetic 8-bit //
 //////////////////////
 
 // Macro: ADD A, r1
 #define MACRO_ADD_A_r1(r1) \
-static uint8_t ADD_A_##r1(void) \
+static uint8_t ADD_A_##r1(OPCODE_ARGS) \
 { \
-    uint16_t t = cpu.reg.A + cpu.reg.r1; \
-    cpu.reg.F = 0; \
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);\
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (cpu.reg.r1 & 0xF) > 0xF); \
-    cpu.reg.Flags.C = (t > 0xFF); \
-    cpu.reg.A = t & 0xFF; \
+    uint16_t t = REG.A + REG.r1; \
+    FLAGS_ADD(REG.A, REG.r1, t); \
+    REG.A = t & 0xFF; \
     return 1; \
 }
 
@@ -354,41 +371,32 @@ MACRO_ADD_A_r1(A);    // ADD A, A
 #undef MACRO_ADD_A_r1
 
 // ADD A, (HL)
-static uint8_t ADD_A_HL(void)
+static uint8_t ADD_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    uint16_t t = cpu.reg.A + reg;
-    cpu.reg.F = 0;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (reg & 0xF) > 0xF);
-    cpu.reg.Flags.C = (t > 0xFF);
-    cpu.reg.A = t & 0xFF;
+    uint8_t reg = mem_read_u8(REG.HL);
+    uint16_t t = REG.A + reg;
+    FLAGS_ADD(REG.A, reg, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // ADD A, d8
-static uint8_t ADD_A_d8(void)
+static uint8_t ADD_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    uint16_t t = cpu.reg.A + d8;
-    cpu.reg.F = 0;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (d8 & 0xF) > 0xF);
-    cpu.reg.Flags.C = (t > 0xFF);
-    cpu.reg.A = t & 0xFF;
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    uint16_t t = REG.A + d8;
+    FLAGS_ADD(REG.A, d8, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // Macro: ADC A, r1
 #define MACRO_ADC_A_r1(r1) \
-static uint8_t ADC_A_##r1(void) \
+static uint8_t ADC_A_##r1(OPCODE_ARGS) \
 { \
-    uint16_t t = cpu.reg.A + cpu.reg.r1 + cpu.reg.Flags.C; \
-    cpu.reg.F = 0; \
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);\
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (cpu.reg.r1 & 0xF) > 0xF); \
-    cpu.reg.Flags.C = (t > 0xFF); \
-    cpu.reg.A = t & 0xFF; \
+    uint16_t t = REG.A + REG.r1 + FLAG_C(); \
+    FLAGS_ADD(REG.A, REG.r1, t); \
+    REG.A = t & 0xFF; \
     return 1; \
 }
 
@@ -403,41 +411,32 @@ MACRO_ADC_A_r1(A);    // ADC A, A
 #undef MACRO_ADC_A_r1
 
 // ADC A, (HL)
-static uint8_t ADC_A_HL(void)
+static uint8_t ADC_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    uint16_t t = cpu.reg.A + reg +  cpu.reg.Flags.C;
-    cpu.reg.F = 0;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (reg & 0xF) > 0xF);
-    cpu.reg.Flags.C = (t > 0xFF);
-    cpu.reg.A = t & 0xFF;
+    uint8_t reg = mem_read_u8(REG.HL);
+    uint16_t t = REG.A + reg + FLAG_C();
+    FLAGS_ADD(REG.A, reg, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // ADC A, d8
-static uint8_t ADC_A_d8(void)
+static uint8_t ADC_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    uint16_t t = cpu.reg.A + d8 +  cpu.reg.Flags.C;
-    cpu.reg.F = 0;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = ((cpu.reg.A & 0xF) + (d8 & 0xF) > 0xF);
-    cpu.reg.Flags.C = (t > 0xFF);
-    cpu.reg.A = t & 0xFF;
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    uint16_t t = REG.A + d8 + FLAG_C();
+    FLAGS_ADD(REG.A, d8, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // Macro: SUB A, r1
 #define MACRO_SUB_A_r1(r1) \
-static uint8_t SUB_A_##r1(void) \
+static uint8_t SUB_A_##r1(OPCODE_ARGS) \
 { \
-    int16_t t = cpu.reg.A - cpu.reg.r1; \
-    cpu.reg.F = 0x40; \
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);\
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) cpu.reg.r1 & 0xF) < 0); \
-    cpu.reg.Flags.C = (t < 0); \
-    cpu.reg.A = t & 0xFF; \
+    uint16_t t = REG.A - REG.r1; \
+    FLAGS_SUB(REG.A, REG.r1, t); \
+    REG.A = t & 0xFF; \
     return 1; \
 }
 
@@ -452,42 +451,33 @@ MACRO_SUB_A_r1(A);    // SUB A, A
 #undef MACRO_SUB_A_r1
 
 // SUB A, (HL)
-static uint8_t SUB_A_HL(void)
+static uint8_t SUB_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    int16_t t = cpu.reg.A - reg;
-    cpu.reg.F = 0x40;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) reg & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
-    cpu.reg.A = t & 0xFF;
+    uint8_t reg = mem_read_u8(REG.HL);
+    uint16_t t = REG.A - reg;
+    FLAGS_SUB(REG.A, reg, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // SUB A, d8
-static uint8_t SUB_A_d8(void)
+static uint8_t SUB_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    int16_t t = cpu.reg.A - d8;
-    cpu.reg.F = 0x40;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) d8 & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
-    cpu.reg.A = t & 0xFF;
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    uint16_t t = REG.A - d8;
+    FLAGS_SUB(REG.A, d8, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 
 // Macro: SBC A, r1
 #define MACRO_SBC_A_r1(r1) \
-static uint8_t SBC_A_##r1(void) \
+static uint8_t SBC_A_##r1(OPCODE_ARGS) \
 { \
-    int16_t t = cpu.reg.A - cpu.reg.r1 - cpu.reg.Flags.C; \
-    cpu.reg.F = 0x40; \
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);\
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) cpu.reg.r1 & 0xF) < 0); \
-    cpu.reg.Flags.C = (t < 0); \
-    cpu.reg.A = t & 0xFF; \
+    uint16_t t = REG.A - REG.r1 - FLAG_C(); \
+    FLAGS_SUB(REG.A, REG.r1, t); \
+    REG.A = t & 0xFF; \
     return 1; \
 }
 
@@ -502,38 +492,31 @@ MACRO_SBC_A_r1(A);    // SBC A, A
 #undef MACRO_SBC_A_r1
 
 // SBC A, (HL)
-static uint8_t SBC_A_HL(void)
+static uint8_t SBC_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    int16_t t = cpu.reg.A - reg - cpu.reg.Flags.C;
-    cpu.reg.F = 0x40;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) reg & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
-    cpu.reg.A = t & 0xFF;
+    uint8_t reg = mem_read_u8(REG.HL);
+    uint16_t t = REG.A - reg - FLAG_C();
+    FLAGS_SUB(REG.A, reg, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // SBC A, d8
-static uint8_t SBC_A_d8(void)
+static uint8_t SBC_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    int16_t t = cpu.reg.A - d8 - cpu.reg.Flags.C;
-    cpu.reg.F = 0x40;
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) d8 & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
-    cpu.reg.A = t & 0xFF;
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    uint16_t t = REG.A - d8 - FLAG_C();
+    FLAGS_SUB(REG.A, d8, t);
+    REG.A = t & 0xFF;
     return 2;
 }
 
 // Macro: AND A, r1
 #define MACRO_AND_A_r1(r1) \
-static uint8_t AND_A_##r1(void) \
+static uint8_t AND_A_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.A &= cpu.reg.r1; \
-    cpu.reg.F = 0x20; /* N = 0, H = 1, C = 0 */ \
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);\
+    REG.A &= REG.r1; \
+    FLAGS_AND(REG.A); \
     return 1; \
 }
 
@@ -548,33 +531,30 @@ MACRO_AND_A_r1(A);    // AND A, A
 #undef MACRO_AND_A_r1
 
 // AND A, (HL)
-static uint8_t AND_A_HL(void)
+static uint8_t AND_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    cpu.reg.A &= reg;
-    cpu.reg.F = 0x20; /* N = 0, H = 1, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t reg = mem_read_u8(REG.HL);
+    REG.A &= reg;
+    FLAGS_AND(REG.A);
     return 2;
 }
 
 // AND A, d8
-static uint8_t AND_A_d8(void)
+static uint8_t AND_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    cpu.reg.A &= d8;
-    cpu.reg.F = 0x20; /* N = 0, H = 1, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    REG.A &= d8;
+    FLAGS_AND(REG.A);
     return 2;
 }
 
 
 // Macro: XOR A, r1
 #define MACRO_XOR_A_r1(r1) \
-static uint8_t XOR_A_##r1(void) \
+static uint8_t XOR_A_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.A ^= cpu.reg.r1; \
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */ \
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);\
+    REG.A ^= REG.r1; \
+    FLAGS_OR(REG.A); \
     return 1; \
 }
 
@@ -589,32 +569,29 @@ MACRO_XOR_A_r1(A);    // XOR A, A
 #undef MACRO_XOR_A_r1
 
 // XOR A, (HL)
-static uint8_t XOR_A_HL(void)
+static uint8_t XOR_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    cpu.reg.A ^= reg;
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t reg = mem_read_u8(REG.HL);
+    REG.A ^= reg;
+    FLAGS_OR(REG.A);
     return 2;
 }
 
 // XOR A, d8
-static uint8_t XOR_A_d8(void)
+static uint8_t XOR_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    cpu.reg.A ^= d8;
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    REG.A ^= d8;
+    FLAGS_OR(REG.A);
     return 2;
 }
 
 // Macro: OR A, r1
 #define MACRO_OR_A_r1(r1) \
-static uint8_t OR_A_##r1(void) \
+static uint8_t OR_A_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.A |= cpu.reg.r1; \
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */ \
-    cpu.reg.Flags.Z = (cpu.reg.A == 0); \
+    REG.A |= REG.r1; \
+    FLAGS_OR(REG.A); \
     return 1; \
 }
 
@@ -629,34 +606,29 @@ MACRO_OR_A_r1(A);    // OR A, A
 #undef MACRO_OR_A_r1
 
 // OR A, (HL)
-static uint8_t OR_A_HL(void)
+static uint8_t OR_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    cpu.reg.A |= reg;
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t reg = mem_read_u8(REG.HL);
+    REG.A |= reg;
+    FLAGS_OR(REG.A);
     return 2;
 }
 
 // OR A, d8
-static uint8_t OR_A_d8(void)
+static uint8_t OR_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.PC + 1);
-    cpu.reg.A |= d8;
-    cpu.reg.F = 0x00; /* N = 0, H = 0, C = 0 */
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    REG.A |= d8;
+    FLAGS_OR(REG.A);
     return 2;
 }
 
 // Macro: CP A, r1
 #define MACRO_CP_A_r1(r1) \
-static uint8_t CP_A_##r1(void) \
+static uint8_t CP_A_##r1(OPCODE_ARGS) \
 { \
-    int16_t t = cpu.reg.A - cpu.reg.r1; \
-    cpu.reg.F = 0x40; /* N = 1 */ \
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0); \
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) cpu.reg.r1 & 0xF) < 0); \
-    cpu.reg.Flags.C = (t < 0); \
+    uint16_t t = REG.A - REG.r1; \
+    FLAGS_SUB(REG.A, REG.r1, t); \
     return 1; \
 }
 
@@ -671,37 +643,29 @@ MACRO_CP_A_r1(A);    // CP A, A
 #undef MACRO_CP_A_r1
 
 // CP A, (HL)
-static uint8_t CP_A_HL(void)
+static uint8_t CP_A_HL(OPCODE_ARGS)
 {
-    uint8_t reg = mem_read_u8(cpu.reg.HL);
-    int16_t t = cpu.reg.A - reg;
-    cpu.reg.F = 0x40; /* N = 1 */
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) reg & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
+    uint8_t reg = mem_read_u8(REG.HL);
+    uint16_t t = REG.A - reg;
+    FLAGS_SUB(REG.A, reg, t);
     return 2;
 }
 
 // CP A, d8
-static uint8_t CP_A_d8(void)
+static uint8_t CP_A_d8(OPCODE_ARGS)
 {
-    uint8_t d8 = mem_read_u8(cpu.reg.HL);
-    int16_t t = cpu.reg.A - d8;
-    cpu.reg.F = 0x40; /* N = 1 */
-    cpu.reg.Flags.Z = ((t & 0xFF) == 0);
-    cpu.reg.Flags.H = (((int8_t) cpu.reg.A & 0xF) - ((int8_t) d8 & 0xF) < 0);
-    cpu.reg.Flags.C = (t < 0);
+    uint8_t d8 = mem_read_u8(REG.PC + 1);
+    uint16_t t = REG.A - d8;
+    FLAGS_SUB(REG.A, d8, t);
     return 2;
 }
 
 // Macro: INC r1
 #define MACRO_INC_r1(r1) \
-static uint8_t INC_##r1(void) \
+static uint8_t INC_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.r1++; \
-    cpu.reg.Flags.Z = (cpu.reg.r1 == 0x00); \
-    cpu.reg.Flags.N = 0; \
-    cpu.reg.Flags.H = ((cpu.reg.r1 & 0x0F) == 0x00); \
+    REG.r1++; \
+    FLAGS_INC(REG.r1); \
     return 1; \
 }
 
@@ -716,27 +680,23 @@ MACRO_INC_r1(A);    // INC A
 #undef MACRO_INC_r1
 
 // INC (HL)
-static uint8_t INC_pHL(void)
+static uint8_t INC_pHL(OPCODE_ARGS)
 {
-    uint8_t t = mem_read_u8(cpu.reg.HL);
+    uint8_t t = mem_read_u8(REG.HL);
 
     t++;
-    cpu.reg.Flags.Z = (t == 0x00);
-    cpu.reg.Flags.N = 0;
-    cpu.reg.Flags.H = ((t & 0x0F) == 0x00);
+    FLAGS_INC(t);
 
-    mem_write_u8(cpu.reg.HL, t);
+    mem_write_u8(REG.HL, t);
     return 3;
 }
 
 // Macro: DEC r1
 #define MACRO_DEC_r1(r1) \
-static uint8_t DEC_##r1(void) \
+static uint8_t DEC_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.r1--; \
-    cpu.reg.Flags.Z = (cpu.reg.r1 == 0x00); \
-    cpu.reg.Flags.N = 1; \
-    cpu.reg.Flags.H = ((cpu.reg.r1 & 0x0F) == 0x0F); \
+    REG.r1--; \
+    FLAGS_DEC(REG.r1); \
     return 1; \
 }
 
@@ -751,16 +711,14 @@ MACRO_DEC_r1(A);    // DEC A
 #undef MACRO_DEC_r1
 
 // DEC (HL)
-static uint8_t DEC_pHL(void)
+static uint8_t DEC_pHL(OPCODE_ARGS)
 {
-    uint8_t t = mem_read_u8(cpu.reg.HL);
+    uint8_t t = mem_read_u8(REG.HL);
 
     t--;
-    cpu.reg.Flags.Z = (t == 0x00);
-    cpu.reg.Flags.N = 1;
-    cpu.reg.Flags.H = ((t & 0x0F) == 0x0F);
+    FLAGS_DEC(t);
 
-    mem_write_u8(cpu.reg.HL, t);
+    mem_write_u8(REG.HL, t);
     return 3;
 }
 
@@ -770,9 +728,9 @@ static uint8_t DEC_pHL(void)
 
 // Macro: INC r1
 #define MACRO_INC_r1(r1) \
-static uint8_t INC_##r1(void) \
+static uint8_t INC_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.r1++; \
+    REG.r1++; \
     return 2; \
 }
 
@@ -785,9 +743,9 @@ MACRO_INC_r1(SP);    // INC SP
 
 // Macro: DEC r1
 #define MACRO_DEC_r1(r1) \
-static uint8_t DEC_##r1(void) \
+static uint8_t DEC_##r1(OPCODE_ARGS) \
 { \
-    cpu.reg.r1--; \
+    REG.r1--; \
     return 2; \
 }
 
@@ -800,17 +758,16 @@ MACRO_DEC_r1(SP);    // DEC SP
 
 // Macro: ADD HL r1
 #define MACRO_ADD_HL_r1(r1) \
-static uint8_t ADD_HL_##r1(void) \
+static uint8_t ADD_HL_##r1(OPCODE_ARGS) \
 { \
-    uint32_t result = (uint32_t) cpu.reg.HL + (uint32_t) cpu.reg.r1; \
+    FLAGS_SYNC(); \
+    uint32_t result = (uint32_t) REG.HL + (uint32_t) REG.r1; \
  \
-    cpu.reg.Flags.N = 0; \
-    cpu.reg.Flags.C = (result > 0xFFFF); \
+    REG.Flags.N = 0; \
+    REG.Flags.C = (result > 0xFFFF); \
+    REG.Flags.H = ((REG.HL & 0xFFF) + (REG.r1 & 0xFFF) > 0xFFF); \
  \
-    if ((cpu.reg.HL & 0xFFF) + (cpu.reg.r1 & 0xFFF) > 0xFFF) \
-        cpu.reg.Flags.H = 1; \
- \
-    cpu.reg.HL = result & 0xFFFF; \
+    REG.HL = result & 0xFFFF; \
     return 2; \
 }
 
@@ -822,18 +779,19 @@ MACRO_ADD_HL_r1(SP);    // ADD HL, SP
 #undef MACRO_ADD_HL_r1
 
 // ADD SP, r8
-static uint8_t ADD_SP_r8(void)
+static uint8_t ADD_SP_r8(OPCODE_ARGS)
 {
-    int8_t r8 = mem_read_s8(cpu.reg.PC + 1);
+    FLAGS_SYNC();
+    int8_t r8 = mem_read_s8(REG.PC + 1);
 
-    cpu.reg.F = 0;
-    if ((cpu.reg.SP & 0x0F) + (r8 & 0x0F) > 0x0F)
-        cpu.reg.Flags.H = 1;
+    REG.F = 0;
+    if ((REG.SP & 0x0F) + (r8 & 0x0F) > 0x0F)
+        REG.Flags.H = 1;
 
-    if ((cpu.reg.SP & 0xFF) + ((uint16_t) r8 & 0xFF) > 0xFF)
-        cpu.reg.Flags.C = 1;
+    if ((REG.SP & 0xFF) + ((uint16_t) r8 & 0xFF) > 0xFF)
+        REG.Flags.C = 1;
 
-    cpu.reg.SP += r8;
+    REG.SP += r8;
     return 4;
 }
 
@@ -842,80 +800,93 @@ static uint8_t ADD_SP_r8(void)
 //////////////////////
 
 // Decimal adjust A register - DAA
-static uint8_t DAA(void)
+static uint8_t DAA(OPCODE_ARGS)
 {
-    if (cpu.reg.Flags.N)
+    FLAGS_SYNC();
+    if (REG.Flags.N)
     {
-        if (cpu.reg.Flags.C || cpu.reg.A > 0x99)
+        if (REG.Flags.C || REG.A > 0x99)
         {
-            cpu.reg.A += 0x60;
-            cpu.reg.Flags.C = 1;
+            REG.A += 0x60;
+            REG.Flags.C = 1;
         }
 
-        if (cpu.reg.Flags.H || (cpu.reg.A & 0x0F) > 0x09)
-            cpu.reg.A += 0x06;
+        if (REG.Flags.H || (REG.A & 0x0F) > 0x09)
+            REG.A += 0x06;
     }
     else
     {
-        if (cpu.reg.Flags.C)
-            cpu.reg.A -= 0x60;
+        if (REG.Flags.C)
+            REG.A -= 0x60;
 
-        if (cpu.reg.Flags.H)
-            cpu.reg.A -= 0x06;
+        if (REG.Flags.H)
+            REG.A -= 0x06;
     }
 
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
-    cpu.reg.Flags.H = 0;
+    REG.Flags.Z = (REG.A == 0);
+    REG.Flags.H = 0;
     return 1;
 }
 
 // Complement A register - CPL
-static uint8_t CPL(void)
+static uint8_t CPL(OPCODE_ARGS)
 {
-    cpu.reg.F |= 0x90; // Set N & H
-    cpu.reg.A ^= 0xFF;
+    FLAGS_SYNC();
+    REG.F |= 0x60; // Set N & H
+    REG.A ^= 0xFF;
     return 1;
 }
 
 // Complement Carry Flag - CCF
-static uint8_t CCF(void)
+static uint8_t CCF(OPCODE_ARGS)
 {
-    cpu.reg.F &= 0x90; // Reset N & H
-    cpu.reg.Flags.C = !cpu.reg.Flags.C;
+    FLAGS_SYNC();
+    REG.F &= 0x90; // Reset N & H
+    REG.Flags.C = !REG.Flags.C;
     return 1;
 }
 
 // Set Carry Flag - SCF
-static uint8_t SCF(void)
+static uint8_t SCF(OPCODE_ARGS)
 {
-    cpu.reg.F &= 0x90; // Reset N & H
-    cpu.reg.Flags.C = 1;
+    FLAGS_SYNC();
+    REG.F &= 0x90; // Reset N & H
+    REG.Flags.C = 1;
     return 1;
 }
 
 // NOP
-static uint8_t NOP(void)
+static uint8_t NOP(OPCODE_ARGS)
 {
     // Do nothing for one cycle
     return 1;
 }
 
 // HALT
-static uint8_t HALT(void)
+static uint8_t HALT(OPCODE_ARGS)
 {
-    // TODO Halt
+    if (!irq.ime && irq_requested())
+    {
+        // HALT bug: no halt, the next opcode byte is read twice
+        cpu.mode = CPU_MODE_HALT_BUG;
+    }
+    else
+    {
+        // Sleep until an IRQ is requested, see cpu_run()
+        cpu.mode = CPU_MODE_HALT;
+    }
     return 1;
 }
 
 // STOP
-static uint8_t STOP(void)
+static uint8_t STOP(OPCODE_ARGS)
 {
     // TODO Stop
     return 1;
 }
 
 // DI
-static uint8_t DI(void)
+static uint8_t DI(OPCODE_ARGS)
 {
     // Disable IRQ
     irq.ime = false;
@@ -923,18 +894,25 @@ static uint8_t DI(void)
 }
 
 // EI
-static uint8_t EI(void)
+static uint8_t EI(OPCODE_ARGS)
 {
     // Enable IRQ
     irq.ime = true;
     return 1;
 }
 
+// Illegal opcode, CPU locks up
+static uint8_t ILLEGAL(OPCODE_ARGS)
+{
+    return 1;
+}
+
 // PREFIX CB
-static uint8_t PREFIX_CB(void)
+static uint8_t PREFIX_CB(OPCODE_ARGS)
 {
+    // PC is left on the prefix, cycles are accounted by the CB opcode
     cpu.prefix_cb = true;
-    return 1;
+    return 0;
 }
 
 //////////////////////
@@ -942,41 +920,45 @@ static uint8_t PREFIX_CB(void)
 //////////////////////
 
 // Rotate A Left
-static uint8_t RLCA(void)
+static uint8_t RLCA(OPCODE_ARGS)
 {
-    cpu.reg.A = (cpu.reg.A << 1) | (cpu.reg.A >> 7);
-    cpu.reg.F = 0x00;
-    cpu.reg.Flags.C = cpu.reg.A & 0x01;
+    FLAGS_SYNC();
+    REG.A = (REG.A << 1) | (REG.A >> 7);
+    REG.F = 0x00;
+    REG.Flags.C = REG.A & 0x01;
     return 1;
 }
 
 // Rotate A Left through Carry flag
-static uint8_t RLA(void)
+static uint8_t RLA(OPCODE_ARGS)
 {
-    uint16_t t = (cpu.reg.A << 1) | cpu.reg.Flags.C;
-    cpu.reg.A = t & 0xFF;
-    cpu.reg.F = 0x00;
-    cpu.reg.Flags.C = (t > 0xFF);
+    FLAGS_SYNC();
+    uint16_t t = (REG.A << 1) | REG.Flags.C;
+    REG.A = t & 0xFF;
+    REG.F = 0x00;
+    REG.Flags.C = (t > 0xFF);
     return 1;
 }
 
 // Rotate A Right
-static uint8_t RRCA(void)
+static uint8_t RRCA(OPCODE_ARGS)
 {
-    cpu.reg.F = 0x00;
-    cpu.reg.Flags.C = cpu.reg.A & 0x01;
-    cpu.reg.Flags.Z = (cpu.reg.A == 0);
-    cpu.reg.A = (cpu.reg.A >> 1) | (cpu.reg.A << 7);
+    FLAGS_SYNC();
+    REG.F = 0x00;
+    REG.Flags.C = REG.A & 0x01;
+    REG.Flags.Z = (REG.A == 0);
+    REG.A = (REG.A >> 1) | (REG.A << 7);
     return 1;
 }
 
 // Rotate A Right through Carry flag
-static uint8_t RRA(void)
+static uint8_t RRA(OPCODE_ARGS)
 {
-    uint8_t t = (cpu.reg.A >> 1) | (cpu.reg.Flags.C << 7);
-    cpu.reg.F = 0x00;
-    cpu.reg.Flags.C = cpu.reg.A & 0x01;
-    cpu.reg.A = t;
+    FLAGS_SYNC();
+    uint8_t t = (REG.A >> 1) | (REG.Flags.C << 7);
+    REG.F = 0x00;
+    REG.Flags.C = REG.A & 0x01;
+    REG.A = t;
     return 1;
 }
 
@@ -985,40 +967,42 @@ static uint8_t RRA(void)
 //////////////////////
 
 // JP a16
-static uint8_t JP_a16(void)
+static uint8_t JP_a16(OPCODE_ARGS)
 {
-    cpu.reg.PC = mem_read_u16(cpu.reg.PC + 1);
+    REG.PC = mem_read_u16(REG.PC + 1);
     return 4;
 }
 
 // JP (HL)
-static uint8_t JP_HL(void)
+static uint8_t JP_HL(OPCODE_ARGS)
 {
-    cpu.reg.PC = mem_read_u16(cpu.reg.HL);
+    REG.PC = mem_read_u16(REG.HL);
     return 1;
 }
 
 // JR r8
-static uint8_t JR_r8(void)
+static uint8_t JR_r8(OPCODE_ARGS)
 {
-    int8_t r8 = mem_read_s8(cpu.reg.PC + 1);
-    cpu.reg.PC += 2 + r8;
+    int8_t r8 = mem_read_s8(REG.PC + 1);
+    if (r8 < 0)
+        idle_check(REG.PC + 2 + r8, REG.PC);
+    REG.PC += 2 + r8;
     return 3;
 }
 
 // Macro: JP COND, a16
 #define MACRO_JP_COND_a16(name, bit, state) \
-static uint8_t JP_##name##_a16(void) \
+static uint8_t JP_##name##_a16(OPCODE_ARGS) \
 { \
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1); \
-    if (cpu.reg.Flags.bit == state) \
+    uint16_t a16 = mem_read_u16(REG.PC + 1); \
+    if (FLAG_##bit() == state) \
     { \
-        cpu.reg.PC = a16; /* Jump */ \
+        REG.PC = a16; /* Jump */ \
         return 4; \
     } \
     else \
     { \
-        cpu.reg.PC += 3; /* Next opcode */ \
+        REG.PC += 3; /* Next opcode */ \
         return 3; \
     } \
 }
@@ -1032,13 +1016,15 @@ MACRO_JP_COND_a16(C, C, 1);     // JP C, a16
 
 // Macro: JR COND r8
 #define MACRO_JR_COND_r8(name, bit, state) \
-static uint8_t JR_##name##_r8(void) \
+static uint8_t JR_##name##_r8(OPCODE_ARGS) \
 { \
-    int8_t r8 = mem_read_s8(cpu.reg.PC + 1); \
-    cpu.reg.PC += 2; \
-    if (cpu.reg.Flags.bit == state) \
+    int8_t r8 = mem_read_s8(REG.PC + 1); \
+    REG.PC += 2; \
+    if (FLAG_##bit() == state) \
     { \
-        cpu.reg.PC += r8; /* Relative jump */ \
+        if (r8 < 0) \
+            idle_check(REG.PC + r8, REG.PC - 2); \
+        REG.PC += r8; /* Relative jump */ \
         return 3; \
     } \
     else \
@@ -1061,19 +1047,19 @@ MACRO_JR_COND_r8(C, C, 1);      // JR C, r8
 
 // Macro: CALL COND, a16
 #define MACRO_CALL_COND_a16(name, bit, state) \
-static uint8_t CALL_##name##_a16(void) \
+static uint8_t CALL_##name##_a16(OPCODE_ARGS) \
 { \
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1); \
-    if (cpu.reg.Flags.bit == state) \
+    uint16_t a16 = mem_read_u16(REG.PC + 1); \
+    if (FLAG_##bit() == state) \
     { \
-        mem_write_u16(cpu.reg.SP - 2, cpu.reg.PC); /* Save PC */ \
-        cpu.reg.PC = a16; /* Jump */ \
-        cpu.reg.SP -= 2; \
+        mem_write_u16(REG.SP - 2, REG.PC); /* Save PC */ \
+        REG.PC = a16; /* Jump */ \
+        REG.SP -= 2; \
         return 6; \
     } \
     else \
     { \
-        cpu.reg.PC += 3; /* Next opcode */ \
+        REG.PC += 3; /* Next opcode */ \
         return 3; \
     } \
 }
@@ -1086,12 +1072,12 @@ MACRO_CALL_COND_a16(C, C, 1);      // CALL C, a16
 #undef MACRO_CALL_COND_a16
 
 // CALL a16
-static uint8_t CALL_a16(void) \
+static uint8_t CALL_a16(OPCODE_ARGS) \
 {
-    uint16_t a16 = mem_read_u16(cpu.reg.PC + 1);
-    mem_write_u16(cpu.reg.SP - 2, cpu.reg.PC + 3);
-    cpu.reg.SP -= 2;
-    cpu.reg.PC = a16;
+    uint16_t a16 = mem_read_u16(REG.PC + 1);
+    mem_write_u16(REG.SP - 2, REG.PC + 3);
+    REG.SP -= 2;
+    REG.PC = a16;
     return 6;
 }
 
@@ -1101,11 +1087,11 @@ static uint8_t CALL_a16(void) \
 
 // Macro: RST nnH
 #define MACRO_RST_nnH(nn) \
-static uint8_t RST_##nn##H(void) \
+static uint8_t RST_##nn##H(OPCODE_ARGS) \
 { \
-    mem_write_u16(cpu.reg.SP - 2, cpu.reg.PC); \
-    cpu.reg.SP -= 2; \
-    cpu.reg.PC = 0x##nn; \
+    mem_write_u16(REG.SP - 2, REG.PC); \
+    REG.SP -= 2; \
+    REG.PC = 0x##nn; \
     return 4; \
 }
 
@@ -1126,26 +1112,26 @@ MACRO_RST_nnH(38);    // RST 38H
 //////////////////////
 
 // RET
-static uint8_t RET(void)
+static uint8_t RET(OPCODE_ARGS)
 {
-    cpu.reg.PC = mem_read_u16(cpu.reg.SP); /* Jump to SP */
-    cpu.reg.SP += 2;
+    REG.PC = mem_read_u16(REG.SP); /* Jump to SP */
+    REG.SP += 2;
     return 4;
 }
 
 // Macro: RET COND
 #define MACRO_RET_COND(name, bit, state) \
-static uint8_t RET_##name(void) \
+static uint8_t RET_##name(OPCODE_ARGS) \
 { \
-    if (cpu.reg.Flags.bit == state) \
+    if (FLAG_##bit() == state) \
     { \
-        cpu.reg.PC = mem_read_u16(cpu.reg.SP); /* Jump to SP */ \
-        cpu.reg.SP += 2; \
+        REG.PC = mem_read_u16(REG.SP); /* Jump to SP */ \
+        REG.SP += 2; \
         return 5; \
     } \
     else \
     { \
-        cpu.reg.PC += 2; /* Next opcode */ \
+        REG.PC += 2; /* Next opcode */ \
         return 2; \
     } \
 }
@@ -1158,271 +1144,339 @@ MACRO_RET_COND(C, C, 1);      // RET C
 #undef MACRO_JR_COND_r8
 
 // RETI
-static uint8_t RETI(void)
+static uint8_t RETI(OPCODE_ARGS)
 {
     // Enable IRQ
     irq.ime = true;
-    cpu.reg.PC = mem_read_u16(cpu.reg.SP);
-    cpu.reg.SP += 2;
+    REG.PC = mem_read_u16(REG.SP);
+    REG.SP += 2;
     return 4;
 }
 
+// Opcode table: X(opcode, function, length, update_pc)
+#define OPCODE_TABLE(X) \
+    X(0x00, NOP,           1, true)             \
+    X(0x01, LD_BC_d16,     3, true)             \
+    X(0x02, LD_BC_A,       1, true)             \
+    X(0x03, INC_BC,        1, true)             \
+    X(0x04, INC_B,         1, true)             \
+    X(0x05, DEC_B,         1, true)             \
+    X(0x06, LD_B_d8,       2, true)             \
+    X(0x07, RLCA,          1, true)             \
+    X(0x08, LD_a16_SP,     3, true)             \
+    X(0x09, ADD_HL_BC,     1, true)             \
+    X(0x0A, LD_A_BC,       1, true)             \
+    X(0x0B, DEC_BC,        1, true)             \
+    X(0x0C, INC_C,         1, true)             \
+    X(0x0D, DEC_C,         1, true)             \
+    X(0x0E, LD_C_d8,       2, true)             \
+    X(0x0F, RRCA,          1, true)             \
+    X(0x10, STOP,          2, true)             \
+    X(0x11, LD_DE_d16,     3, true)             \
+    X(0x12, LD_DE_A,       1, true)             \
+    X(0x13, INC_DE,        1, true)             \
+    X(0x14, INC_D,         1, true)             \
+    X(0x15, DEC_D,         1, true)             \
+    X(0x16, LD_D_d8,       2, true)             \
+    X(0x17, RLA,           1, true)             \
+    X(0x18, JR_r8,         2, false)            \
+    X(0x19, ADD_HL_DE,     1, true)             \
+    X(0x1A, LD_A_DE,       1, true)             \
+    X(0x1B, DEC_DE,        1, true)             \
+    X(0x1C, INC_E,         1, true)             \
+    X(0x1D, DEC_E,         1, true)             \
+    X(0x1E, LD_E_d8,       2, true)             \
+    X(0x1F, RRA,           1, true)             \
+    X(0x20, JR_NZ_r8,      2, false)            \
+    X(0x21, LD_HL_d16,     3, true)             \
+    X(0x22, LD_HLp_A,      1, true)             \
+    X(0x23, INC_HL,        1, true)             \
+    X(0x24, INC_H,         1, true)             \
+    X(0x25, DEC_H,         1, true)             \
+    X(0x26, LD_H_d8,       2, true)             \
+    X(0x27, DAA,           1, true)             \
+    X(0x28, JR_Z_r8,       2, false)            \
+    X(0x29, ADD_HL_HL,     1, true)             \
+    X(0x2A, LD_A_HLp,      1, true)             \
+    X(0x2B, DEC_HL,        1, true)             \
+    X(0x2C, INC_L,         1, true)             \
+    X(0x2D, DEC_L,         1, true)             \
+    X(0x2E, LD_L_d8,       2, true)             \
+    X(0x2F, CPL,           1, true)             \
+    X(0x30, JR_NC_r8,      2, false)            \
+    X(0x31, LD_SP_d16,     3, true)             \
+    X(0x32, LD_HLm_A,      1, true)             \
+    X(0x33, INC_SP,        1, true)             \
+    X(0x34, INC_pHL,       1, true)             \
+    X(0x35, DEC_pHL,       1, true)             \
+    X(0x36, LD_HL_d8,      1, true)             \
+    X(0x37, SCF,           1, true)             \
+    X(0x38, JR_C_r8,       2, false)            \
+    X(0x39, ADD_HL_SP,     1, true)             \
+    X(0x3A, LD_A_HLm,      1, true)             \
+    X(0x3B, DEC_SP,        1, true)             \
+    X(0x3C, INC_A,         1, true)             \
+    X(0x3D, DEC_A,         1, true)             \
+    X(0x3E, LD_A_d8,       2, true)             \
+    X(0x3F, CCF,           1, true)             \
+    X(0x40, LD_B_B,        1, true)             \
+    X(0x41, LD_B_C,        1, true)             \
+    X(0x42, LD_B_D,        1, true)             \
+    X(0x43, LD_B_E,        1, true)             \
+    X(0x44, LD_B_H,        1, true)             \
+    X(0x45, LD_B_L,        1, true)             \
+    X(0x46, LD_B_HL,       1, true)             \
+    X(0x47, LD_B_A,        1, true)             \
+    X(0x48, LD_C_B,        1, true)             \
+    X(0x49, LD_C_C,        1, true)             \
+    X(0x4A, LD_C_D,        1, true)             \
+    X(0x4B, LD_C_E,        1, true)             \
+    X(0x4C, LD_C_H,        1, true)             \
+    X(0x4D, LD_C_L,        1, true)             \
+    X(0x4E, LD_C_HL,       1, true)             \
+    X(0x4F, LD_C_A,        1, true)             \
+    X(0x50, LD_D_B,        1, true)             \
+    X(0x51, LD_D_C,        1, true)             \
+    X(0x52, LD_D_D,        1, true)             \
+    X(0x53, LD_D_E,        1, true)             \
+    X(0x54, LD_D_H,        1, true)             \
+    X(0x55, LD_D_L,        1, true)             \
+    X(0x56, LD_D_HL,       1, true)             \
+    X(0x57, LD_D_A,        1, true)             \
+    X(0x58, LD_E_B,        1, true)             \
+    X(0x59, LD_E_C,        1, true)             \
+    X(0x5A, LD_E_D,        1, true)             \
+    X(0x5B, LD_E_E,        1, true)             \
+    X(0x5C, LD_E_H,        1, true)             \
+    X(0x5D, LD_E_L,        1, true)             \
+    X(0x5E, LD_E_HL,       1, true)             \
+    X(0x5F, LD_E_A,        1, true)             \
+    X(0x60, LD_H_B,        1, true)             \
+    X(0x61, LD_H_C,        1, true)             \
+    X(0x62, LD_H_D,        1, true)             \
+    X(0x63, LD_H_E,        1, true)             \
+    X(0x64, LD_H_H,        1, true)             \
+    X(0x65, LD_H_L,        1, true)             \
+    X(0x66, LD_H_HL,       1, true)             \
+    X(0x67, LD_H_A,        1, true)             \
+    X(0x68, LD_L_B,        1, true)             \
+    X(0x69, LD_L_C,        1, true)             \
+    X(0x6A, LD_L_D,        1, true)             \
+    X(0x6B, LD_L_E,        1, true)             \
+    X(0x6C, LD_L_H,        1, true)             \
+    X(0x6D, LD_L_L,        1, true)             \
+    X(0x6E, LD_L_HL,       1, true)             \
+    X(0x6F, LD_L_A,        1, true)             \
+    X(0x70, LD_HL_B,       1, true)             \
+    X(0x71, LD_HL_C,       1, true)             \
+    X(0x72, LD_HL_D,       1, true)             \
+    X(0x73, LD_HL_E,       1, true)             \
+    X(0x74, LD_HL_H,       1, true)             \
+    X(0x75, LD_HL_L,       1, true)             \
+    X(0x76, HALT,          1, true)             \
+    X(0x77, LD_HL_A,       1, true)             \
+    X(0x78, LD_A_B,        1, true)             \
+    X(0x79, LD_A_C,        1, true)             \
+    X(0x7A, LD_A_D,        1, true)             \
+    X(0x7B, LD_A_E,        1, true)             \
+    X(0x7C, LD_A_H,        1, true)             \
+    X(0x7D, LD_A_L,        1, true)             \
+    X(0x7E, LD_A_HL,       1, true)             \
+    X(0x7F, LD_A_A,        1, true)             \
+    X(0x80, ADD_A_B,       1, true)             \
+    X(0x81, ADD_A_C,       1, true)             \
+    X(0x82, ADD_A_D,       1, true)             \
+    X(0x83, ADD_A_E,       1, true)             \
+    X(0x84, ADD_A_H,       1, true)             \
+    X(0x85, ADD_A_L,       1, true)             \
+    X(0x86, ADD_A_HL,      1, true)             \
+    X(0x87, ADD_A_A,       1, true)             \
+    X(0x88, ADC_A_B,       1, true)             \
+    X(0x89, ADC_A_C,       1, true)             \
+    X(0x8A, ADC_A_D,       1, true)             \
+    X(0x8B, ADC_A_E,       1, true)             \
+    X(0x8C, ADC_A_H,       1, true)             \
+    X(0x8D, ADC_A_L,       1, true)             \
+    X(0x8E, ADC_A_HL,      1, true)             \
+    X(0x8F, ADC_A_A,       1, true)             \
+    X(0x90, SUB_A_B,       1, true)             \
+    X(0x91, SUB_A_C,       1, true)             \
+    X(0x92, SUB_A_D,       1, true)             \
+    X(0x93, SUB_A_E,       1, true)             \
+    X(0x94, SUB_A_H,       1, true)             \
+    X(0x95, SUB_A_L,       1, true)             \
+    X(0x96, SUB_A_HL,      1, true)             \
+    X(0x97, SUB_A_A,       1, true)             \
+    X(0x98, SBC_A_B,       1, true)             \
+    X(0x99, SBC_A_C,       1, true)             \
+    X(0x9A, SBC_A_D,       1, true)             \
+    X(0x9B, SBC_A_E,       1, true)             \
+    X(0x9C, SBC_A_H,       1, true)             \
+    X(0x9D, SBC_A_L,       1, true)             \
+    X(0x9E, SBC_A_HL,      1, true)             \
+    X(0x9F, SBC_A_A,       1, true)             \
+    X(0xA0, AND_A_B,       1, true)             \
+    X(0xA1, AND_A_C,       1, true)             \
+    X(0xA2, AND_A_D,       1, true)             \
+    X(0xA3, AND_A_E,       1, true)             \
+    X(0xA4, AND_A_H,       1, true)             \
+    X(0xA5, AND_A_L,       1, true)             \
+    X(0xA6, AND_A_HL,      1, true)             \
+    X(0xA7, AND_A_A,       1, true)             \
+    X(0xA8, XOR_A_B,       1, true)             \
+    X(0xA9, XOR_A_C,       1, true)             \
+    X(0xAA, XOR_A_D,       1, true)             \
+    X(0xAB, XOR_A_E,       1, true)             \
+    X(0xAC, XOR_A_H,       1, true)             \
+    X(0xAD, XOR_A_L,       1, true)             \
+    X(0xAE, XOR_A_HL,      1, true)             \
+    X(0xAF, XOR_A_A,       1, true)             \
+    X(0xB0, OR_A_B,        1, true)             \
+    X(0xB1, OR_A_C,        1, true)             \
+    X(0xB2, OR_A_D,        1, true)             \
+    X(0xB3, OR_A_E,        1, true)             \
+    X(0xB4, OR_A_H,        1, true)             \
+    X(0xB5, OR_A_L,        1, true)             \
+    X(0xB6, OR_A_HL,       1, true)             \
+    X(0xB7, OR_A_A,        1, true)             \
+    X(0xB8, CP_A_B,        1, true)             \
+    X(0xB9, CP_A_C,        1, true)             \
+    X(0xBA, CP_A_D,        1, true)             \
+    X(0xBB, CP_A_E,        1, true)             \
+    X(0xBC, CP_A_H,        1, true)             \
+    X(0xBD, CP_A_L,        1, true)             \
+    X(0xBE, CP_A_HL,       1, true)             \
+    X(0xBF, CP_A_A,        1, true)             \
+    X(0xC0, RET_NZ,        1, false)            \
+    X(0xC1, POP_BC,        1, true)             \
+    X(0xC2, JP_NZ_a16,     3, false)            \
+    X(0xC3, JP_a16,        3, false)            \
+    X(0xC4, CALL_NZ_a16,   3, false)            \
+    X(0xC5, PUSH_BC,       1, true)             \
+    X(0xC6, ADD_A_d8,      2, true)             \
+    X(0xC7, RST_00H,       1, false)            \
+    X(0xC8, RET_Z,         1, false)            \
+    X(0xC9, RET,           1, false)            \
+    X(0xCA, JP_Z_a16,      3, false)            \
+    X(0xCB, PREFIX_CB,     1, false)            \
+    X(0xCC, CALL_Z_a16,    3, false)            \
+    X(0xCD, CALL_a16,      3, false)            \
+    X(0xCE, ADC_A_d8,      2, true)             \
+    X(0xCF, RST_08H,       1, false)            \
+    X(0xD0, RET_NC,        1, false)            \
+    X(0xD1, POP_DE,        1, true)             \
+    X(0xD2, JP_NC_a16,     3, false)            \
+    X(0xD3, ILLEGAL,       0, false)            \
+    X(0xD4, CALL_NC_a16,   3, false)            \
+    X(0xD5, PUSH_DE,       1, true)             \
+    X(0xD6, SUB_A_d8,      2, true)             \
+    X(0xD7, RST_10H,       1, false)            \
+    X(0xD8, RET_C,         1, false)            \
+    X(0xD9, RETI,          1, false)            \
+    X(0xDA, JP_C_a16,      3, false)            \
+    X(0xDB, ILLEGAL,       0, false)            \
+    X(0xDC, CALL_C_a16,    3, false)            \
+    X(0xDD, ILLEGAL,       0, false)            \
+    X(0xDE, SBC_A_d8,      2, true)             \
+    X(0xDF, RST_18H,       1, false)            \
+    X(0xE0, LDH_a8_A,      2, true)             \
+    X(0xE1, POP_HL,        1, true)             \
+    X(0xE2, LD_pC_A,       2, true)             \
+    X(0xE3, ILLEGAL,       0, false)            \
+    X(0xE4, ILLEGAL,       0, false)            \
+    X(0xE5, PUSH_HL,       1, true)             \
+    X(0xE6, AND_A_d8,      2, true)             \
+    X(0xE7, RST_20H,       1, false)            \
+    X(0xE8, ADD_SP_r8,     2, true)             \
+    X(0xE9, JP_HL,         1, false)            \
+    X(0xEA, LD_a16_A,      3, true)             \
+    X(0xEB, ILLEGAL,       0, false)            \
+    X(0xEC, ILLEGAL,       0, false)            \
+    X(0xED, ILLEGAL,       0, false)            \
+    X(0xEE, XOR_A_d8,      2, true)             \
+    X(0xEF, RST_28H,       1, false)            \
+    X(0xF0, LDH_A_a8,      2, true)             \
+    X(0xF1, POP_AF,        1, true)             \
+    X(0xF2, LD_A_pC,       2, true)             \
+    X(0xF3, DI,            1, true)             \
+    X(0xF4, ILLEGAL,       0, false)            \
+    X(0xF5, PUSH_AF,       1, true)             \
+    X(0xF6, OR_A_d8,       2, true)             \
+    X(0xF7, RST_30H,       1, false)            \
+    X(0xF8, LD_HL_SP_r8,   2, true)             \
+    X(0xF9, LD_SP_HL,      1, false)            \
+    X(0xFA, LD_A_a16,      3, true)             \
+    X(0xFB, EI,            1, true)             \
+    X(0xFC, ILLEGAL,       0, false)            \
+    X(0xFD, ILLEGAL,       0, false)            \
+    X(0xFE, CP_A_d8,       2, true)             \
+    X(0xFF, RST_38H,       1, false)
+
+#define OPCODE_ENTRY(code, func, length, update_pc)     [code] = {func, length, update_pc},
+
 struct opcode_t opcodeList[256] =
 {
-    {NOP,           1,      true},      // 0x00
-    {LD_BC_d16,     3,      true},      // 0x01
-    {LD_BC_A,       1,      true},      // 0x02
-    {INC_BC,        1,      true},      // 0x03
-    {INC_B,         1,      true},      // 0x04
-    {DEC_B,         1,      true},      // 0x05
-    {LD_B_d8,       2,      true},      // 0x06
-    {RLCA,          1,      true},      // 0x07
-    {LD_a16_SP,     3,      true},      // 0x08
-    {ADD_HL_BC,     1,      true},      // 0x09
-    {LD_A_BC,       1,      true},      // 0x0A
-    {DEC_BC,        1,      true},      // 0x0B
-    {INC_C,         1,      true},      // 0x0C
-    {DEC_C,         1,      true},      // 0x0D
-    {LD_C_d8,       2,      true},      // 0x0E
-    {RRCA,          1,      true},      // 0x0F
-    {STOP,          2,      true},      // 0x10
-    {LD_DE_d16,     3,      true},      // 0x11
-    {LD_DE_A,       1,      true},      // 0x12
-    {INC_DE,        1,      true},      // 0x13
-    {INC_D,         1,      true},      // 0x14
-    {DEC_D,         1,      true},      // 0x15
-    {LD_D_d8,       2,      true},      // 0x16
-    {RLA,           1,      true},      // 0x17
-    {JR_r8,         2,      false},     // 0x18
-    {ADD_HL_DE,     1,      true},      // 0x19
-    {LD_A_DE,       1,      true},      // 0x1A
-    {DEC_DE,        1,      true},      // 0x1B
-    {INC_E,         1,      true},      // 0x1C
-    {DEC_E,         1,      true},      // 0x1D
-    {LD_E_d8,       2,      true},      // 0x1E
-    {RRA,           1,      true},      // 0x1F
-    {JR_NZ_r8,      2,      false},     // 0x20
-    {LD_HL_d16,     3,      true},      // 0x21
-    {LD_HLp_A,      1,      true},      // 0x22
-    {INC_HL,        1,      true},      // 0x23
-    {INC_H,         1,      true},      // 0x24
-    {DEC_H,         1,      true},      // 0x25
-    {LD_H_d8,       2,      true},      // 0x26
-    {DAA,           1,      true},      // 0x27
-    {JR_Z_r8,       2,      false},     // 0x28
-    {ADD_HL_HL,     1,      true},      // 0x29
-    {LD_A_HLp,      1,      true},      // 0x2A
-    {DEC_HL,        1,      true},      // 0x2B
-    {INC_L,         1,      true},      // 0x2C
-    {DEC_L,         1,      true},      // 0x2D
-    {LD_L_d8,       2,      true},      // 0x2E
-    {CPL,           1,      true},      // 0x2F
-    {JR_NC_r8,      2,      false},     // 0x30
-    {LD_SP_d16,     3,      true},      // 0x31
-    {LD_HLm_A,      1,      true},      // 0x32
-    {INC_SP,        1,      true},      // 0x33
-    {INC_pHL,       1,      true},      // 0x34
-    {DEC_pHL,       1,      true},      // 0x35
-    {LD_HL_d8,      1,      true},      // 0x36
-    {SCF,           1,      true},      // 0x37
-    {JR_C_r8,       2,      false},     // 0x38
-    {ADD_HL_SP,     1,      true},      // 0x39
-    {LD_A_HLm,      1,      true},      // 0x3A
-    {DEC_SP,        1,      true},      // 0x3B
-    {INC_A,         1,      true},      // 0x3C
-    {DEC_A,         1,      true},      // 0x3D
-    {LD_A_d8,       2,      true},      // 0x3E
-    {CCF,           1,      true},      // 0x3F
-    {LD_B_B,        1,      true},      // 0x40
-    {LD_B_C,        1,      true},      // 0x41
-    {LD_B_D,        1,      true},      // 0x42
-    {LD_B_E,        1,      true},      // 0x43
-    {LD_B_H,        1,      true},      // 0x44
-    {LD_B_L,        1,      true},      // 0x45
-    {LD_B_HL,       1,      true},      // 0x46
-    {LD_B_A,        1,      true},      // 0x47
-    {LD_C_B,        1,      true},      // 0x48
-    {LD_C_C,        1,      true},      // 0x49
-    {LD_C_D,        1,      true},      // 0x4A
-    {LD_C_E,        1,      true},      // 0x4B
-    {LD_C_H,        1,      true},      // 0x4C
-    {LD_C_L,        1,      true},      // 0x4D
-    {LD_C_HL,       1,      true},      // 0x4E
-    {LD_C_A,        1,      true},      // 0x4F
-    {LD_D_B,        1,      true},      // 0x50
-    {LD_D_C,        1,      true},      // 0x51
-    {LD_D_D,        1,      true},      // 0x52
-    {LD_D_E,        1,      true},      // 0x53
-    {LD_D_H,        1,      true},      // 0x54
-    {LD_D_L,        1,      true},      // 0x55
-    {LD_D_HL,       1,      true},      // 0x56
-    {LD_D_A,        1,      true},      // 0x57
-    {LD_E_B,        1,      true},      // 0x58
-    {LD_E_C,        1,      true},      // 0x59
-    {LD_E_D,        1,      true},      // 0x5A
-    {LD_E_E,        1,      true},      // 0x5B
-    {LD_E_H,        1,      true},      // 0x5C
-    {LD_E_L,        1,      true},      // 0x5D
-    {LD_E_HL,       1,      true},      // 0x5E
-    {LD_E_A,        1,      true},      // 0x5F
-    {LD_H_B,        1,      true},      // 0x60
-    {LD_H_C,        1,      true},      // 0x61
-    {LD_H_D,        1,      true},      // 0x62
-    {LD_H_E,        1,      true},      // 0x63
-    {LD_H_H,        1,      true},      // 0x64
-    {LD_H_L,        1,      true},      // 0x65
-    {LD_H_HL,       1,      true},      // 0x66
-    {LD_H_A,        1,      true},      // 0x67
-    {LD_L_B,        1,      true},      // 0x68
-    {LD_L_C,        1,      true},      // 0x69
-    {LD_L_D,        1,      true},      // 0x6A
-    {LD_L_E,        1,      true},      // 0x6B
-    {LD_L_H,        1,      true},      // 0x6C
-    {LD_L_L,        1,      true},      // 0x6D
-    {LD_L_HL,       1,      true},      // 0x6E
-    {LD_L_A,        1,      true},      // 0x6F
-    {LD_HL_B,       1,      true},      // 0x70
-    {LD_HL_C,       1,      true},      // 0x71
-    {LD_HL_D,       1,      true},      // 0x72
-    {LD_HL_E,       1,      true},      // 0x73
-    {LD_HL_H,       1,      true},      // 0x74
-    {LD_HL_L,       1,      true},      // 0x75
-    {HALT,          1,      true},      // 0x76
-    {LD_HL_A,       1,      true},      // 0x77
-    {LD_A_B,        1,      true},      // 0x78
-    {LD_A_C,        1,      true},      // 0x79
-    {LD_A_D,        1,      true},      // 0x7A
-    {LD_A_E,        1,      true},      // 0x7B
-    {LD_A_H,        1,      true},      // 0x7C
-    {LD_A_L,        1,      true},      // 0x7D
-    {LD_A_HL,       1,      true},      // 0x7E
-    {LD_A_A,        1,      true},      // 0x7F
-    {ADD_A_B,       1,      true},      // 0x80
-    {ADD_A_C,       1,      true},      // 0x81
-    {ADD_A_D,       1,      true},      // 0x82
-    {ADD_A_E,       1,      true},      // 0x83
-    {ADD_A_H,       1,      true},      // 0x84
-    {ADD_A_L,       1,      true},      // 0x85
-    {ADD_A_HL,      1,      true},      // 0x86
-    {ADD_A_A,       1,      true},      // 0x87
-    {ADC_A_B,       1,      true},      // 0x88
-    {ADC_A_C,       1,      true},      // 0x89
-    {ADC_A_D,       1,      true},      // 0x8A
-    {ADC_A_E,       1,      true},      // 0x8B
-    {ADC_A_H,       1,      true},      // 0x8C
-    {ADC_A_L,       1,      true},      // 0x8D
-    {ADC_A_HL,      1,      true},      // 0x8E
-    {ADC_A_A,       1,      true},      // 0x8F
-    {SUB_A_B,       1,      true},      // 0x90
-    {SUB_A_C,       1,      true},      // 0x91
-    {SUB_A_D,       1,      true},      // 0x92
-    {SUB_A_E,       1,      true},      // 0x93
-    {SUB_A_H,       1,      true},      // 0x94
-    {SUB_A_L,       1,      true},      // 0x95
-    {SUB_A_HL,      1,      true},      // 0x96
-    {SUB_A_A,       1,      true},      // 0x97
-    {SBC_A_B,       1,      true},      // 0x98
-    {SBC_A_C,       1,      true},      // 0x99
-    {SBC_A_D,       1,      true},      // 0x9A
-    {SBC_A_E,       1,      true},      // 0x9B
-    {SBC_A_H,       1,      true},      // 0x9C
-    {SBC_A_L,       1,      true},      // 0x9D
-    {SBC_A_HL,      1,      true},      // 0x9E
-    {SBC_A_A,       1,      true},      // 0x9F
-    {AND_A_B,       1,      true},      // 0xA0
-    {AND_A_C,       1,      true},      // 0xA1
-    {AND_A_D,       1,      true},      // 0xA2
-    {AND_A_E,       1,      true},      // 0xA3
-    {AND_A_H,       1,      true},      // 0xA4
-    {AND_A_L,       1,      true},      // 0xA5
-    {AND_A_HL,      1,      true},      // 0xA6
-    {AND_A_A,       1,      true},      // 0xA7
-    {XOR_A_B,       1,      true},      // 0xA8
-    {XOR_A_C,       1,      true},      // 0xA9
-    {XOR_A_D,       1,      true},      // 0xAA
-    {XOR_A_E,       1,      true},      // 0xAB
-    {XOR_A_H,       1,      true},      // 0xAC
-    {XOR_A_L,       1,      true},      // 0xAD
-    {XOR_A_HL,      1,      true},      // 0xAE
-    {XOR_A_A,       1,      true},      // 0xAF
-    {OR_A_B,        1,      true},      // 0xB0
-    {OR_A_C,        1,      true},      // 0xB1
-    {OR_A_D,        1,      true},      // 0xB2
-    {OR_A_E,        1,      true},      // 0xB3
-    {OR_A_H,        1,      true},      // 0xB4
-    {OR_A_L,        1,      true},      // 0xB5
-    {OR_A_HL,       1,      true},      // 0xB6
-    {OR_A_A,        1,      true},      // 0xB7
-    {CP_A_B,        1,      true},      // 0xB8
-    {CP_A_C,        1,      true},      // 0xB9
-    {CP_A_D,        1,      true},      // 0xBA
-    {CP_A_E,        1,      true},      // 0xBB
-    {CP_A_H,        1,      true},      // 0xBC
-    {CP_A_L,        1,      true},      // 0xBD
-    {CP_A_HL,       1,      true},      // 0xBE
-    {CP_A_A,        1,      true},      // 0xBF
-    {RET_NZ,        1,      false},     // 0xC0
-    {POP_BC,        1,      true},      // 0xC1
-    {JP_NZ_a16,     3,      false},     // 0xC2
-    {JP_a16,        3,      true},      // 0xC3
-    {CALL_NZ_a16,   3,      false},     // 0xC4
-    {PUSH_BC,       1,      true},      // 0xC5
-    {ADD_A_d8,      2,      true},      // 0xC6
-    {RST_00H,       1,      false},     // 0xC7
-    {RET_Z,         1,      false},     // 0xC8
-    {RET,           1,      false},     // 0xC9
-    {JP_Z_a16,      3,      false},     // 0xCA
-    {PREFIX_CB,     1,      true},      // 0xCB
-    {CALL_Z_a16,    3,      false},     // 0xCC
-    {CALL_a16,      3,      false},     // 0xCD
-    {ADC_A_d8,      2,      true},      // 0xCE
-    {RST_08H,       1,      false},     // 0xCF
-    {RET_NC,        1,      false},     // 0xD0
-    {POP_DE,        1,      true},      // 0xD1
-    {JP_NC_a16,     3,      false},     // 0xD2
-    {NULL,          0,      false},     // 0xD3
-    {CALL_NC_a16,   3,      false},     // 0xD4
-    {PUSH_DE,       1,      true},      // 0xD5
-    {SUB_A_d8,      2,      true},      // 0xD6
-    {RST_10H,       1,      false},     // 0xD7
-    {RET_C,         1,      false},     // 0xD8
-    {RETI,          1,      false},     // 0xD9
-    {JP_C_a16,      3,      false},     // 0xDA
-    {NULL,          0,      false},     // 0xDB
-    {CALL_C_a16,    3,      false},     // 0xDC
-    {NULL,          0,      false},     // 0xDD
-    {SBC_A_d8,      2,      true},      // 0xDE
-    {RST_18H,       1,      false},     // 0xDF
-    {LDH_a8_A,      2,      true},      // 0xE0
-    {POP_HL,        1,      true},      // 0xE1
-    {LD_pC_A,       2,      true},      // 0xE2
-    {NULL,          0,      false},     // 0xE3
-    {NULL,          0,      false},     // 0xE4
-    {PUSH_HL,       1,      true},      // 0xE5
-    {AND_A_d8,      2,      true},      // 0xE6
-    {RST_20H,       1,      false},     // 0xE7
-    {ADD_SP_r8,     2,      true},      // 0xE8
-    {JP_HL,         1,      false},     // 0xE9
-    {LD_a16_A,      3,      true},      // 0xEA
-    {NULL,          0,      false},     // 0xEB
-    {NULL,          0,      false},     // 0xEC
-    {NULL,          0,      false},     // 0xED
-    {XOR_A_d8,      2,      true},      // 0xEE
-    {RST_28H,       1,      false},     // 0xEF
-    {LDH_A_a8,      2,      true},      // 0xF0
-    {POP_AF,        1,      true},      // 0xF1
-    {LD_A_pC,       2,      true},      // 0xF2
-    {DI,            1,      true},      // 0xF3
-    {NULL,          0,      false},     // 0xF4
-    {PUSH_AF,       1,      true},      // 0xF5
-    {OR_A_d8,       2,      true},      // 0xF6
-    {RST_30H,       1,      false},     // 0xF7
-    {LD_HL_SP_r8,   2,      true},      // 0xF8
-    {LD_SP_HL,      1,      false},     // 0xF9
-    {LD_A_a16,      3,      true},      // 0xFA
-    {EI,            1,      true},      // 0xFB
-    {NULL,          0,      false},     // 0xFC
-    {NULL,          0,      false},     // 0xFD
-    {CP_A_d8,       2,      true},      // 0xFE
-    {RST_38H,       1,      false},     // 0xFF
+    OPCODE_TABLE(OPCODE_ENTRY)
 };
+
+#undef OPCODE_ENTRY
+
+#ifdef CPU_DISPATCH_SWITCH
+
+#define OPCODE_CASE(code, func, length, update_pc) \
+    case code: \
+        step = func(&reg); \
+        if (update_pc) \
+            reg.PC += length; \
+        break;
+
+uint32_t opcode_run(uint32_t budget)
+{
+    struct cpu_reg_t reg = cpu.reg;
+    uint32_t cycles = 0;
+
+    // Stop at HALT or idle loop, cpu_run() handles it
+    while ((cycles < budget) && (cpu.mode == CPU_MODE_RUN))
+    {
+        uint8_t step;
+
+        if (irq_pending())
+        {
+            // IRQ context switch works on cpu.reg
+            cpu.reg = reg;
+            irq_check();
+            reg = cpu.reg;
+            step = cpu.cycle_counter;
+        }
+        else
+        {
+            uint8_t opcode = mem_read_u8(reg.PC);
+            PROFILE_INSTRUCTION();
+
+            if (opcode == 0xCB)
+            {
+                // Work on a copy so that reg address never escapes
+                struct cpu_reg_t cb_reg = reg;
+                step = opcode_cb_exec(&cb_reg, mem_read_u8(reg.PC + 1));
+                reg = cb_reg;
+            }
+            else
+            {
+                switch (opcode)
+                {
+                    OPCODE_TABLE(OPCODE_CASE)
+                }
+            }
+        }
+
+        cpu.cycles += step;
+        cycles += step;
+    }
+
+    cpu.reg = reg;
+    return cycles;
+}
+
+#undef OPCODE_CASE
+
+#endif
@@ -6,7 +6,13 @@
  */
 
 #include <gameboy/ppu.h>
+#include <gameboy/irq.h>
 #include <gameboy/mem.h>
+#include <gameboy/profile.h>
+#include <gameboy/sched.h>
+#include <gameboy/tile.h>
+#include <stddef.h>
+#include <string.h>
 
 #define STATE_HBLANK_DURATION       51
 #define STATE_VBLANK_DURATION       114
@@ -18,6 +24,15 @@
 
 #define OAM_NB                      40
 
+// VRAM offsets
+#define VRAM_TILE_MAP_9800          0x1800
+#define VRAM_TILE_MAP_9C00          0x1C00
+
+#define TILE_MAP_WIDTH              32
+#define TILE_8800_BASE              256     // Signed tile number, 0 at 0x9000
+
+#define PALETTE_BLANK               PPU_PALETTE_NB  // LCD off
+
 struct oam_entry_t
 {
     uint8_t Y;
@@ -28,16 +43,39 @@ struct oam_entry_t
         uint8_t Flags;
         struct
         {
-            uint8_t Priority : 1;
-            uint8_t Y_Flip : 1;
-            uint8_t X_Flip : 1;
-            uint8_t Palette : 1;
             uint8_t : 4;
+            uint8_t Palette : 1;
+            uint8_t X_Flip : 1;
+            uint8_t Y_Flip : 1;
+            uint8_t Priority : 1; // Behind BG colors 1-3
         };
     };
 };
 
-struct ppu_t ppu;
+GAMEBOY_CONTEXT struct ppu_t ppu =
+{
+    // Output settings are kept by ppu_init()
+    .format = PPU_FORMAT_L8,
+    .aColor = {PPU_COLOR_WHITE, PPU_COLOR_LIGHT_GRAY, PPU_COLOR_DARK_GRAY, PPU_COLOR_BLACK},
+    .aPixel = {0, 1, 2, 3},
+};
+
+// Bits per pixel of each format
+static const uint8_t aFormatBpp[PPU_FORMAT_NB] =
+{
+    [PPU_FORMAT_L8]         = 8,
+    [PPU_FORMAT_2BPP]       = 2,
+    [PPU_FORMAT_RGB565]     = 16,
+    [PPU_FORMAT_ARGB8888]   = 32,
+};
+
+static const uint8_t aStateDuration[] =
+{
+    [STATE_HBLANK]      = STATE_HBLANK_DURATION,
+    [STATE_VBLANK]      = STATE_VBLANK_DURATION,
+    [STATE_OAM_SEARCH]  = STATE_OAM_SEARCH_DURATION,
+    [STATE_PXL_XFER]    = STATE_PXL_XFER_DURATION,
+};
 
 /**
  * Search of 10 visible sprites
@@ -71,7 +109,370 @@ static inline void exec_oam_search(void)
         }
     }
 
-    // TODO Sort sprite array?
+    // Lowest X first, OAM order on same X (insertion sort, stable)
+    for (int i = 1 ; i < ppu.OAM_counter ; i++)
+    {
+        uint8_t n = ppu.aOAM_visible[i];
+        int j = i - 1;
+
+        while ((j >= 0) && (pOam[ppu.aOAM_visible[j]].X > pOam[n].X))
+        {
+            ppu.aOAM_visible[j + 1] = ppu.aOAM_visible[j];
+            j--;
+        }
+        ppu.aOAM_visible[j + 1] = n;
+    }
+}
+
+/**
+ * Fetch count BG/window color indexes from the tile map line at map, from
+ * pixel x (wraps at 256)
+ */
+static void fetch_tiles(const uint8_t *pVRAM, uint16_t map, uint8_t x, uint8_t row, uint8_t *pIndex, uint8_t count)
+{
+    while (count > 0)
+    {
+        uint8_t number = pVRAM[map + (x >> 3)];
+        uint16_t tile;
+
+        if (ppu.pReg->LCDC_Flags.BGWindowTileData)
+            tile = number;
+        else
+            tile = TILE_8800_BASE + (int8_t) number;
+
+        const uint8_t *pPixel = tile_get_row(tile, row);
+
+        uint8_t n = 8 - (x & 0x07);
+        if (n > count)
+            n = count;
+
+        memcpy(pIndex, &pPixel[x & 0x07], n);
+        pIndex += n;
+        x += n;
+        count -= n;
+    }
+}
+
+/**
+ * Write a line of palette << 2 | color index to the framebuffer, the LUTs
+ * give the final pixels
+ */
+static void write_framebuffer(const uint8_t *pIndex)
+{
+    uint32_t offset = ppu.y * PPU_SCREEN_WIDTH;
+
+    switch (ppu.format)
+    {
+        case PPU_FORMAT_L8:
+        {
+            uint8_t *pDst = (uint8_t *) ppu.pFramebuffer + offset;
+            for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x++)
+                pDst[x] = ppu.aPalette[pIndex[x]];
+            break;
+        }
+
+        case PPU_FORMAT_2BPP:
+        {
+            const ppu_pixel_t *pShade = ppu.aPalette;
+            uint8_t *pDst = (uint8_t *) ppu.pFramebuffer + offset / 4;
+
+            // 4 pixels packed per byte
+            for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x += 4)
+                *pDst++ = (pShade[pIndex[x]] << 6) | (pShade[pIndex[x + 1]] << 4) |
+                          (pShade[pIndex[x + 2]] << 2) | pShade[pIndex[x + 3]];
+            break;
+        }
+
+        case PPU_FORMAT_RGB565:
+        {
+            uint16_t *pDst = (uint16_t *) ppu.pFramebuffer + offset;
+            for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x++)
+                pDst[x] = ppu.aPalettePixel[pIndex[x]];
+            break;
+        }
+
+        case PPU_FORMAT_ARGB8888:
+        {
+            uint32_t *pDst = (uint32_t *) ppu.pFramebuffer + offset;
+            for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x++)
+                pDst[x] = ppu.aPalettePixel[pIndex[x]];
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Hand a rendered line to the framebuffer, the line sink and the frame hash.
+ * The sink and the hash take shades, the L8 framebuffer line is one
+ */
+static inline void emit_line(const uint8_t *pIndex)
+{
+    const ppu_pixel_t *pLine = NULL;
+    ppu_pixel_t aLine[PPU_SCREEN_WIDTH];
+
+    if (ppu.pFramebuffer)
+    {
+        write_framebuffer(pIndex);
+        if (ppu.format == PPU_FORMAT_L8)
+            pLine = (ppu_pixel_t *) ppu.pFramebuffer + ppu.y * PPU_SCREEN_WIDTH;
+    }
+
+    if (!ppu.hash_enable && (NULL == ppu.line_sink))
+        return;
+
+    if (NULL == pLine)
+    {
+        for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x++)
+            aLine[x] = ppu.aPalette[pIndex[x]];
+        pLine = aLine;
+    }
+
+    if (ppu.hash_enable)
+    {
+        if (ppu.y == 0)
+            hash_stream_init(&ppu.hash_stream);
+
+        hash_stream_update(&ppu.hash_stream, pLine, PPU_SCREEN_WIDTH * sizeof(ppu_pixel_t));
+
+        if (ppu.y == PPU_SCREEN_HEIGHT - 1)
+            ppu.frame_hash = hash_stream_digest(&ppu.hash_stream);
+    }
+
+    if (ppu.line_sink)
+        ppu.line_sink(ppu.y, pLine);
+}
+
+/**
+ * Render line ppu.y: background, window then sprites
+ */
+static inline void exec_pxl_xfer(void)
+{
+    struct ppu_reg_t *pReg = ppu.pReg;
+    const uint8_t *pVRAM = mem_get_vram();
+    uint8_t aIndex[PPU_SCREEN_WIDTH]; // Palette << 2 | color index, BGP is 0
+
+    if (((NULL == ppu.pFramebuffer) && (NULL == ppu.line_sink) && !ppu.hash_enable) || ppu.skip_frame)
+        return;
+
+    if (!pReg->LCDC_Flags.DisplayEnable)
+    {
+        memset(aIndex, PALETTE_BLANK << 2, PPU_SCREEN_WIDTH);
+        emit_line(aIndex);
+        return;
+    }
+
+    // Background & window, both disabled by BGEnable on DMG
+    if (pReg->LCDC_Flags.BGEnable)
+    {
+        uint8_t y = pReg->SCY + ppu.y;
+        uint16_t map = pReg->LCDC_Flags.BGTileMapAddr ? VRAM_TILE_MAP_9C00 : VRAM_TILE_MAP_9800;
+
+        fetch_tiles(pVRAM, map + (y >> 3) * TILE_MAP_WIDTH, pReg->SCX, y & 0x07, aIndex, PPU_SCREEN_WIDTH);
+
+        if (pReg->LCDC_Flags.WindowEnable && (ppu.y >= pReg->WY) && (pReg->WX < PPU_SCREEN_WIDTH + 7))
+        {
+            // WX = 7 is the left edge of the screen
+            uint8_t start = (pReg->WX >= 7) ? pReg->WX - 7 : 0;
+            uint8_t x = (pReg->WX >= 7) ? 0 : 7 - pReg->WX;
+
+            map = pReg->LCDC_Flags.WindowTileMapAddr ? VRAM_TILE_MAP_9C00 : VRAM_TILE_MAP_9800;
+            fetch_tiles(pVRAM, map + (ppu.window_y >> 3) * TILE_MAP_WIDTH, x, ppu.window_y & 0x07, &aIndex[start], PPU_SCREEN_WIDTH - start);
+            ppu.window_y++;
+        }
+    }
+    else
+    {
+        memset(aIndex, 0, PPU_SCREEN_WIDTH);
+    }
+
+    // Sprites, by priority: a pixel is owned by the first sprite not
+    // transparent there, even when it is hidden by the background
+    if (pReg->LCDC_Flags.OBJEnable)
+    {
+        struct oam_entry_t *pOam = (struct oam_entry_t *) mem_get_oam_ram();
+        uint8_t sprite_size = pReg->LCDC_Flags.OBJSize ? 16 : 8;
+        bool aOwned[PPU_SCREEN_WIDTH] = {false};
+
+        for (int i = 0 ; i < ppu.OAM_counter ; i++)
+        {
+            struct oam_entry_t *pSprite = &pOam[ppu.aOAM_visible[i]];
+            uint8_t palette = (PPU_PALETTE_OBP0 + pSprite->Palette) << 2;
+            uint8_t tile = (sprite_size == 16) ? pSprite->Number & 0xFE : pSprite->Number;
+            uint8_t row = ppu.y + 16 - pSprite->Y;
+
+            if (pSprite->Y_Flip)
+                row = sprite_size - 1 - row;
+
+            const uint8_t *pPixel = tile_get_row(tile + (row >> 3), row & 0x07);
+
+            for (int p = 0 ; p < 8 ; p++)
+            {
+                int x = pSprite->X - 8 + p;
+                uint8_t index = pPixel[pSprite->X_Flip ? 7 - p : p];
+
+                if ((x < 0) || (x >= PPU_SCREEN_WIDTH) || (index == 0) || aOwned[x])
+                    continue;
+
+                // Not owned yet, aIndex[x] is still the background
+                aOwned[x] = true;
+                if (pSprite->Priority && (aIndex[x] != 0))
+                    continue;
+
+                aIndex[x] = palette | index;
+            }
+        }
+    }
+
+    emit_line(aIndex);
+}
+
+/**
+ * Decide whether the frame starting is rendered
+ */
+static void start_frame(void)
+{
+    bool skip = false;
+
+    ppu.frame_counter++;
+
+    switch (ppu.frame_skip)
+    {
+        case PPU_FRAME_SKIP_FIXED:
+            skip = (ppu.frame_counter % ppu.frame_interval) != 0;
+            break;
+
+        case PPU_FRAME_SKIP_AUTO:
+        {
+            uint32_t now = ppu.clock_us();
+            int32_t lag = now - ppu.frame_deadline_us;
+
+            // Late by a whole frame: skip, but show progress from time to time
+            if ((lag >= PPU_FRAME_PERIOD_US) && (ppu.skip_counter < PPU_FRAME_SKIP_MAX))
+                skip = true;
+
+            // Too late to catch up, or ahead: restart from now
+            if ((lag >= PPU_FRAME_PERIOD_US * PPU_FRAME_SKIP_MAX) || (lag < -PPU_FRAME_PERIOD_US))
+                ppu.frame_deadline_us = now;
+
+            ppu.frame_deadline_us += PPU_FRAME_PERIOD_US;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    ppu.skip_frame = skip;
+    if (skip)
+    {
+        ppu.skip_counter++;
+        ppu.skipped_frame_counter++;
+    }
+    else
+    {
+        ppu.skip_counter = 0;
+    }
+}
+
+/**
+ * Update LY & STAT and raise the IRQs of the state being entered
+ */
+static inline void enter_state(bool new_line)
+{
+    struct ppu_reg_t *pReg = ppu.pReg;
+    uint8_t irq_mask = 0;
+
+    pReg->STAT_Flags.ModeFlag = ppu.state;
+
+    switch (ppu.state)
+    {
+        case STATE_HBLANK:
+            if (pReg->STAT_Flags.Mode0_HBlank)
+                irq_mask |= IRQ_MASK_LCDC;
+            break;
+
+        case STATE_VBLANK:
+            if (ppu.y == LINE_VISIBLE_MAX)
+            {
+                irq_mask |= IRQ_MASK_VBLANK;
+                if (pReg->STAT_Flags.Mode1_VBlank)
+                    irq_mask |= IRQ_MASK_LCDC;
+            }
+            break;
+
+        case STATE_OAM_SEARCH:
+            if (pReg->STAT_Flags.Mode2_OAM)
+                irq_mask |= IRQ_MASK_LCDC;
+            break;
+
+        default:
+            break;
+    }
+
+    if (new_line)
+    {
+        pReg->LY = ppu.y;
+        pReg->STAT_Flags.LYCeqLY_Flag = (ppu.y == pReg->LYC);
+        if (pReg->STAT_Flags.LYCeqLY_Flag && pReg->STAT_Flags.LYCeqLY)
+            irq_mask |= IRQ_MASK_LCDC;
+    }
+
+    if (irq_mask)
+        irq_request(irq_mask);
+}
+
+/**
+ * Scheduler event: end of current state
+ */
+static void ppu_event(void)
+{
+    ppu_run(aStateDuration[ppu.state] - ppu.state_counter);
+    sched_set(SCHED_EVENT_PPU, aStateDuration[ppu.state]);
+}
+
+/**
+ * STAT: mode and LYC flag are read-only, bit 7 reads as 1
+ */
+static void io_write_stat(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    ppu.pReg->STAT = 0x80 | (Value & 0x78) | (ppu.pReg->STAT & 0x07);
+}
+
+/**
+ * LY: read-only
+ */
+static void io_write_ly(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    (void) Value;
+}
+
+/**
+ * LYC: the LY = LYC flag follows
+ */
+static void io_write_lyc(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    ppu.pReg->LYC = Value;
+    ppu.pReg->STAT_Flags.LYCeqLY_Flag = (ppu.pReg->LY == Value);
+}
+
+/**
+ * BGP, OBP0, OBP1: palette LUT rebuilt on change
+ */
+static void io_write_palette(uint16_t Addr, uint8_t Value)
+{
+    enum ppu_palette_t palette = Addr - 0xFF47;
+
+    if ((&ppu.pReg->BGP)[palette] != Value)
+    {
+        (&ppu.pReg->BGP)[palette] = Value;
+        ppu_update_palette(palette);
+    }
 }
 
 void ppu_init(void)
@@ -84,52 +485,229 @@ void ppu_init(void)
     // Start at y = 0 & x = 0
     ppu.y = 0;
     ppu.x = 0;
+    ppu.window_y = 0;
+    ppu.skip_frame = false;
+    ppu.skip_counter = 0;
+    ppu.frame_counter = 0;
+    ppu.skipped_frame_counter = 0;
+    ppu.pReg->STAT |= 0x80;
+    exec_oam_search();
+    enter_state(true);
+
+    for (int i = 0 ; i < PPU_PALETTE_NB ; i++)
+        ppu_update_palette(i);
+
+    mem_register_io(0xFF41, NULL, io_write_stat);
+    mem_register_io(0xFF44, NULL, io_write_ly);
+    mem_register_io(0xFF45, NULL, io_write_lyc);
+    mem_register_io(0xFF47, NULL, io_write_palette);
+    mem_register_io(0xFF48, NULL, io_write_palette);
+    mem_register_io(0xFF49, NULL, io_write_palette);
+
+    sched_register(SCHED_EVENT_PPU, ppu_event);
+    sched_set(SCHED_EVENT_PPU, aStateDuration[ppu.state]);
 }
 
-void ppu_exec(void)
+/**
+ * Leave current state and enter the next one
+ */
+static inline void next_state(void)
 {
+    uint8_t y = ppu.y;
+
+    ppu.state_counter = 0;
+
     switch(ppu.state)
     {
         case STATE_HBLANK:
-            if (ppu.state_counter >= STATE_HBLANK_DURATION)
-            {
-                ppu.y++;
-                ppu.state_counter = 0;
-                if (ppu.y >= LINE_VISIBLE_MAX)
-                    ppu.state = STATE_VBLANK;
-                else
-                    ppu.state = STATE_OAM_SEARCH;
-            }
+            ppu.y++;
+            if (ppu.y >= LINE_VISIBLE_MAX)
+                ppu.state = STATE_VBLANK;
+            else
+                ppu.state = STATE_OAM_SEARCH;
             break;
 
         case STATE_VBLANK:
-            if (ppu.state_counter >= STATE_VBLANK_DURATION)
+            ppu.y++;
+            if (ppu.y >= LINE_MAX)
             {
-                ppu.y++;
-                ppu.state_counter = 0;
-                if (ppu.y >= LINE_MAX)
-                    ppu.state = STATE_OAM_SEARCH;
-                else
-                    ppu.state = STATE_VBLANK_DURATION;
+                ppu.y = 0;
+                ppu.window_y = 0;
+                ppu.state = STATE_OAM_SEARCH;
+                start_frame();
             }
             break;
 
         case STATE_OAM_SEARCH:
-            if (ppu.state_counter == 0)
-                exec_oam_search();
-            if (ppu.state_counter >= STATE_OAM_SEARCH_DURATION)
-            {
-                ppu.state_counter = 0;
-                ppu.state = STATE_PXL_XFER;
-            }
+            ppu.state = STATE_PXL_XFER;
             break;
 
         case STATE_PXL_XFER:
-            if (ppu.state_counter >= STATE_PXL_XFER_DURATION)
-            {
-                ppu.state_counter = 0;
-                ppu.state = STATE_HBLANK;
-            }
+            exec_pxl_xfer();
+            ppu.state = STATE_HBLANK;
+            break;
+    }
+
+    if (ppu.state == STATE_OAM_SEARCH)
+        exec_oam_search();
+
+    enter_state(ppu.y != y);
+}
+
+/**
+ * Render to a framebuffer of ppu_framebuffer_size() bytes. NULL: no rendering
+ */
+void ppu_set_framebuffer(void *pFramebuffer, enum ppu_format_t format)
+{
+    ppu.pFramebuffer = pFramebuffer;
+    ppu.format = format;
+    ppu_set_colors(ppu.aColor);
+    ppu.line_sink = NULL;
+}
+
+/**
+ * Stream lines to a sink instead of a framebuffer. NULL: no rendering
+ */
+void ppu_set_line_sink(ppu_line_sink_t line_sink)
+{
+    ppu.pFramebuffer = NULL;
+    ppu.line_sink = line_sink;
+}
+
+/**
+ * Rebuild the pixels of the palette LUT entries, from their shades
+ */
+static void update_palette_pixels(uint8_t first, uint8_t count)
+{
+    for (uint8_t i = first ; i < first + count ; i++)
+        ppu.aPalettePixel[i] = ppu.aPixel[ppu.aPalette[i]];
+}
+
+/**
+ * Set the ARGB8888 colors of the shades, white to black
+ */
+void ppu_set_colors(const uint32_t aColor[4])
+{
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        uint32_t color = aColor[i];
+
+        ppu.aColor[i] = color;
+
+        switch (ppu.format)
+        {
+            case PPU_FORMAT_RGB565:
+                ppu.aPixel[i] = ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+                break;
+
+            case PPU_FORMAT_ARGB8888:
+                ppu.aPixel[i] = color;
+                break;
+
+            default: // Indexed
+                ppu.aPixel[i] = i;
+                break;
+        }
+    }
+
+    update_palette_pixels(0, sizeof(ppu.aPalette));
+}
+
+/**
+ * Skip rendering of frames, clock_us is only used by PPU_FRAME_SKIP_AUTO,
+ * which falls back to PPU_FRAME_SKIP_FIXED without clock. Emulation is the
+ * same whatever the mode
+ */
+void ppu_set_frame_skip(enum ppu_frame_skip_t mode, uint8_t interval, uint32_t (*clock_us)(void))
+{
+    if ((mode == PPU_FRAME_SKIP_AUTO) && (NULL == clock_us))
+        mode = PPU_FRAME_SKIP_FIXED;
+
+    ppu.frame_skip = mode;
+    ppu.frame_interval = interval ? interval : 1;
+    ppu.clock_us = clock_us;
+    ppu.skip_counter = 0;
+
+    if (mode == PPU_FRAME_SKIP_AUTO)
+        ppu.frame_deadline_us = clock_us();
+}
+
+/**
+ * Hash the shades of every frame rendered in ppu.frame_hash, complete from
+ * the next frame. Lines are rendered even without line sink, skipped frames
+ * are not hashed
+ */
+void ppu_set_frame_hash(bool enable)
+{
+    ppu.hash_enable = enable;
+    hash_stream_init(&ppu.hash_stream);
+    ppu.frame_hash = 0;
+}
+
+uint32_t ppu_framebuffer_size(enum ppu_format_t format)
+{
+    return PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT * aFormatBpp[format] / 8;
+}
+
+/**
+ * Whether a rendering position read from a state is one the PPU can reach:
+ * a known state not past its end, V-Blank lines in V-Blank only, and
+ * visible sprites among the 40 of OAM
+ */
+bool ppu_check_state(uint8_t State, uint8_t Counter, uint8_t Y, uint8_t OAMCounter, const uint8_t *pOAMVisible)
+{
+    if ((State >= sizeof(aStateDuration)) || (Counter > aStateDuration[State]))
+        return false;
+
+    if ((State == STATE_VBLANK) ? ((Y < LINE_VISIBLE_MAX) || (Y >= LINE_MAX)) : (Y >= LINE_VISIBLE_MAX))
+        return false;
+
+    if (OAMCounter > PPU_OAM_VISIBLE_MAX)
+        return false;
+
+    for (uint8_t i = 0 ; i < OAMCounter ; i++)
+        if (pOAMVisible[i] >= OAM_NB)
+            return false;
+
+    return true;
+}
+
+/**
+ * Rebuild the LUTs of a palette, to be called when its register changes
+ */
+void ppu_update_palette(enum ppu_palette_t palette)
+{
+    uint8_t value = (&ppu.pReg->BGP)[palette];
+
+    for (int i = 0 ; i < 4 ; i++)
+        ppu.aPalette[(palette << 2) | i] = (value >> (i * 2)) & 0x03;
+
+    update_palette_pixels(palette << 2, 4);
+}
+
+void ppu_exec(void)
+{
+    ppu_run(1);
+}
+
+void ppu_run(uint32_t cycles)
+{
+    PROFILE_ENTER(PROFILE_PPU);
+
+    // Catch up on the CPU, one state at a time
+    while (cycles > 0)
+    {
+        uint8_t remaining = aStateDuration[ppu.state] - ppu.state_counter;
+
+        if (cycles < remaining)
+        {
+            ppu.state_counter += cycles;
             break;
+        }
+
+        cycles -= remaining;
+        next_state();
     }
+
+    PROFILE_EXIT();
 }
@@ -0,0 +1,237 @@
+/*
+ * rewind.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/rewind.h>
+#include <gameboy/state.h>
+#include <string.h>
+
+#define REWIND_FRAME_SIZE   4 // Delta size, before and after the delta
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct rewind_ring_t rewind_ring;
+
+/**
+ * Largest delta of a snapshot, framing included: every byte changed
+ */
+static uint32_t get_delta_max(uint32_t StateSize)
+{
+    return StateSize + (StateSize + REWIND_LITERAL_MAX - 1) / REWIND_LITERAL_MAX + 2 * REWIND_FRAME_SIZE;
+}
+
+static inline uint32_t ring_offset(uint32_t Offset, int32_t Step)
+{
+    return (Offset + rewind_ring.ring_size + Step) % rewind_ring.ring_size;
+}
+
+static inline void ring_put(uint32_t *pOffset, uint8_t Value)
+{
+    rewind_ring.pRing[*pOffset] = Value;
+    if (++*pOffset == rewind_ring.ring_size)
+        *pOffset = 0;
+}
+
+static inline uint8_t ring_get(uint32_t *pOffset)
+{
+    uint8_t value = rewind_ring.pRing[*pOffset];
+    if (++*pOffset == rewind_ring.ring_size)
+        *pOffset = 0;
+    return value;
+}
+
+static void ring_put_u32(uint32_t Offset, uint32_t Value)
+{
+    for (int i = 0 ; i < 4 ; i++)
+        ring_put(&Offset, Value >> (i * 8));
+}
+
+static uint32_t ring_get_u32(uint32_t Offset)
+{
+    uint32_t value = 0;
+
+    for (int i = 0 ; i < 4 ; i++)
+        value |= (uint32_t) ring_get(&Offset) << (i * 8);
+    return value;
+}
+
+/**
+ * Bytes from Offset equal in both snapshots, compared 8 bytes at a time
+ */
+static uint32_t count_equal(const uint8_t *pA, const uint8_t *pB, uint32_t Offset, uint32_t Max)
+{
+    uint32_t end = (Offset + Max < rewind_ring.state_size) ? Offset + Max : rewind_ring.state_size;
+    uint32_t i = Offset;
+
+    while (i + 8 <= end)
+    {
+        uint64_t a, b;
+
+        memcpy(&a, &pA[i], 8);
+        memcpy(&b, &pB[i], 8);
+        if (a != b)
+            break;
+        i += 8;
+    }
+
+    while ((i < end) && (pA[i] == pB[i]))
+        i++;
+
+    return i - Offset;
+}
+
+/**
+ * Encode pScratch XOR pReference at the head of the ring, return its size
+ */
+static uint32_t encode(void)
+{
+    const uint8_t *pNew = rewind_ring.pScratch;
+    const uint8_t *pOld = rewind_ring.pReference;
+    uint32_t size = rewind_ring.state_size;
+    uint32_t start = ring_offset(rewind_ring.head, REWIND_FRAME_SIZE);
+    uint32_t offset = start;
+    uint32_t i = 0;
+
+    while (i < size)
+    {
+        uint32_t equal = count_equal(pNew, pOld, i, REWIND_ZERO_MAX);
+
+        // Short runs are cheaper in a literal
+        if ((equal >= 3) || (i + equal == size))
+        {
+            ring_put(&offset, 0x80 | ((equal - 1) >> 8));
+            ring_put(&offset, (equal - 1) & 0xFF);
+            i += equal;
+            continue;
+        }
+
+        uint32_t literal = 0;
+        while ((i + literal < size) && (literal < REWIND_LITERAL_MAX) &&
+               (count_equal(pNew, pOld, i + literal, 3) < 3))
+            literal++;
+
+        ring_put(&offset, literal - 1);
+        for (uint32_t j = 0 ; j < literal ; j++, i++)
+            ring_put(&offset, pNew[i] ^ pOld[i]);
+    }
+
+    return (offset + rewind_ring.ring_size - start) % rewind_ring.ring_size;
+}
+
+/**
+ * XOR a delta of the ring into the reference snapshot
+ */
+static void decode(uint32_t Offset)
+{
+    uint8_t *pState = rewind_ring.pReference;
+    uint32_t i = 0;
+
+    while (i < rewind_ring.state_size)
+    {
+        uint8_t control = ring_get(&Offset);
+
+        if (control & 0x80)
+        {
+            i += (((control & 0x7F) << 8) | ring_get(&Offset)) + 1;
+            continue;
+        }
+
+        for (uint32_t j = 0 ; j <= control ; j++, i++)
+            pState[i] ^= ring_get(&Offset);
+    }
+}
+
+static void drop_oldest(void)
+{
+    uint32_t size = ring_get_u32(rewind_ring.tail) + 2 * REWIND_FRAME_SIZE;
+
+    rewind_ring.tail = ring_offset(rewind_ring.tail, size);
+    rewind_ring.used -= size;
+    rewind_ring.snapshot_nb--;
+}
+
+/**
+ * Split the arena in two snapshots and the ring, to be called after
+ * gameboy_init(). False if the arena can't hold one delta
+ */
+bool rewind_init(uint8_t *pArena, uint32_t Size, uint8_t Interval)
+{
+    uint32_t size = state_size();
+
+    if (Size < 2 * size + get_delta_max(size))
+        return false;
+
+    rewind_ring.pReference = pArena;
+    rewind_ring.pScratch = &pArena[size];
+    rewind_ring.pRing = &pArena[2 * size];
+    rewind_ring.state_size = size;
+    rewind_ring.ring_size = Size - 2 * size;
+    rewind_ring.head = 0;
+    rewind_ring.tail = 0;
+    rewind_ring.used = 0;
+    rewind_ring.snapshot_nb = 0;
+    rewind_ring.interval = Interval ? Interval : 1;
+    rewind_ring.frame_counter = 0;
+
+    // First delta is the whole snapshot
+    memset(rewind_ring.pReference, 0, size);
+
+    return true;
+}
+
+/**
+ * To be called after each frame, captures a snapshot every interval frames
+ */
+void rewind_frame(void)
+{
+    if (++rewind_ring.frame_counter < rewind_ring.interval)
+        return;
+    rewind_ring.frame_counter = 0;
+
+    // Room for the largest delta
+    while (rewind_ring.ring_size - rewind_ring.used < get_delta_max(rewind_ring.state_size))
+        drop_oldest();
+
+    state_save(rewind_ring.pScratch, rewind_ring.state_size);
+
+    uint32_t size = encode();
+    ring_put_u32(rewind_ring.head, size);
+    ring_put_u32(ring_offset(rewind_ring.head, REWIND_FRAME_SIZE + size), size);
+    rewind_ring.head = ring_offset(rewind_ring.head, size + 2 * REWIND_FRAME_SIZE);
+    rewind_ring.used += size + 2 * REWIND_FRAME_SIZE;
+    rewind_ring.snapshot_nb++;
+
+    uint8_t *pSwap = rewind_ring.pReference;
+    rewind_ring.pReference = rewind_ring.pScratch;
+    rewind_ring.pScratch = pSwap;
+}
+
+/**
+ * Load the newest snapshot and drop it, the next call goes further back.
+ * False if there is none left
+ */
+bool rewind_back(void)
+{
+    if ((rewind_ring.snapshot_nb == 0) || !state_load(rewind_ring.pReference, rewind_ring.state_size))
+        return false;
+
+    uint32_t size = ring_get_u32(ring_offset(rewind_ring.head, -REWIND_FRAME_SIZE));
+    rewind_ring.head = ring_offset(rewind_ring.head, -(int32_t) (size + 2 * REWIND_FRAME_SIZE));
+    rewind_ring.used -= size + 2 * REWIND_FRAME_SIZE;
+    rewind_ring.snapshot_nb--;
+
+    decode(ring_offset(rewind_ring.head, REWIND_FRAME_SIZE));
+    rewind_ring.frame_counter = 0;
+
+    return true;
+}
+
+/**
+ * Bytes of the arena in use: both snapshots and the deltas
+ */
+uint32_t rewind_footprint(void)
+{
+    return 2 * rewind_ring.state_size + rewind_ring.used;
+}
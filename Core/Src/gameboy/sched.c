@@ -0,0 +1,124 @@
+/*
+ * sched.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/sched.h>
+#include <gameboy/cpu.h>
+#include <stddef.h>
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct sched_t sched;
+
+// Wrap safe comparison of timestamps
+#define TIME_BEFORE(a, b)   ((int32_t) ((a) - (b)) < 0)
+
+/**
+ * Search for the nearest active event
+ */
+static void update_next(void)
+{
+    sched.next = SCHED_EVENT_NB;
+
+    for (uint8_t i = 0 ; i < SCHED_EVENT_NB ; i++)
+    {
+        if (sched.aEvent[i].active)
+        {
+            if ((sched.next == SCHED_EVENT_NB) || TIME_BEFORE(sched.aEvent[i].deadline, sched.aEvent[sched.next].deadline))
+                sched.next = i;
+        }
+    }
+}
+
+void sched_init(void)
+{
+    sched.next = SCHED_EVENT_NB;
+    sched.current = SCHED_EVENT_NB;
+    sched.target = 0;
+    sched.end = 0;
+
+    for (uint8_t i = 0 ; i < SCHED_EVENT_NB ; i++)
+    {
+        sched.aEvent[i].func = NULL;
+        sched.aEvent[i].deadline = 0;
+        sched.aEvent[i].active = false;
+    }
+}
+
+void sched_register(enum sched_event_id_t id, void (*func)(void))
+{
+    sched.aEvent[id].func = func;
+}
+
+/**
+ * Schedule an event delay cycles after now, or after the deadline of the
+ * event being serviced so that periodic events don't drift when the CPU
+ * overshoots
+ */
+void sched_set(enum sched_event_id_t id, uint32_t delay)
+{
+    uint32_t base = cpu.cycles;
+
+    if (sched.current != SCHED_EVENT_NB)
+        base = sched.aEvent[sched.current].deadline;
+
+    sched_set_at(id, base + delay);
+}
+
+/**
+ * Schedule an event at an absolute cycle count
+ */
+void sched_set_at(enum sched_event_id_t id, uint32_t deadline)
+{
+    sched.aEvent[id].deadline = deadline;
+    sched.aEvent[id].active = true;
+    update_next();
+
+    // Set by an instruction, before the end of the CPU budget
+    if ((sched.current == SCHED_EVENT_NB) && TIME_BEFORE(deadline, sched.target))
+        cpu_break();
+}
+
+void sched_cancel(enum sched_event_id_t id)
+{
+    sched.aEvent[id].active = false;
+    update_next();
+}
+
+/**
+ * Run cycles from the end of the previous run, not from where the last
+ * instruction overshot it, so that runs of a frame stay on the frame
+ * boundary
+ */
+void sched_run(uint32_t cycles)
+{
+    uint32_t end = sched.end + cycles;
+    sched.end = end;
+
+    while (TIME_BEFORE(cpu.cycles, end))
+    {
+        // Run CPU uninterrupted until the nearest event
+        uint32_t target = end;
+        if ((sched.next != SCHED_EVENT_NB) && TIME_BEFORE(sched.aEvent[sched.next].deadline, end))
+            target = sched.aEvent[sched.next].deadline;
+
+        if (TIME_BEFORE(cpu.cycles, target))
+        {
+            sched.target = target;
+            cpu_run(target - cpu.cycles);
+            sched.target = cpu.cycles;
+        }
+
+        // Service expired events only
+        while ((sched.next != SCHED_EVENT_NB) && !TIME_BEFORE(cpu.cycles, sched.aEvent[sched.next].deadline))
+        {
+            sched.current = sched.next;
+            sched.aEvent[sched.current].active = false;
+            update_next();
+            sched.aEvent[sched.current].func();
+            sched.current = SCHED_EVENT_NB;
+        }
+    }
+}
@@ -0,0 +1,333 @@
+/*
+ * state.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/state.h>
+#include <gameboy/cpu.h>
+#include <gameboy/idle.h>
+#include <gameboy/irq.h>
+#include <gameboy/joypad.h>
+#include <gameboy/mbc.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/sched.h>
+#include <gameboy/tile.h>
+#include <gameboy/timer.h>
+
+#define STATE_HEADER_SIZE   10
+
+// Furthest event: TIMA overflow after 256 ticks of 256 cycles
+#define STATE_EVENT_DELAY_MAX   (256 << 8)
+
+/**
+ * Cartridge the state belongs to, then its controller registers
+ */
+static void save_mbc(struct state_stream_t *pStream)
+{
+    state_put_u8(pStream, mbc.type);
+    state_put_u16(pStream, mbc.rom_bank_nb);
+    state_put_u8(pStream, mbc.ram_bank_nb);
+
+    state_put_u8(pStream, mbc.ram_enable);
+    state_put_u16(pStream, mbc.bank_low);
+    state_put_u8(pStream, mbc.bank_high);
+    state_put_u8(pStream, mbc.mode);
+}
+
+static void load_mbc(struct state_stream_t *pStream)
+{
+    // Cartridge checked by state_load()
+    pStream->offset += 4;
+
+    mbc.ram_enable = state_get_u8(pStream);
+    mbc.bank_low = state_get_u16(pStream);
+    mbc.bank_high = state_get_u8(pStream);
+    mbc.mode = state_get_u8(pStream);
+}
+
+/**
+ * Registers with F up to date, lazy flags are not saved. Buttons held are
+ * saved with the CPU, a state then replays the same inputs
+ */
+static void save_cpu(struct state_stream_t *pStream)
+{
+    cpu_sync_flags();
+
+    state_put_u16(pStream, cpu.reg.AF);
+    state_put_u16(pStream, cpu.reg.BC);
+    state_put_u16(pStream, cpu.reg.DE);
+    state_put_u16(pStream, cpu.reg.HL);
+    state_put_u16(pStream, cpu.reg.SP);
+    state_put_u16(pStream, cpu.reg.PC);
+
+    state_put_u8(pStream, cpu.mode);
+    state_put_u8(pStream, cpu.idle_cycles);
+    state_put_u8(pStream, cpu.cycle_counter);
+    state_put_u32(pStream, cpu.cycles);
+    state_put_u8(pStream, cpu.prefix_cb);
+
+    state_put_u8(pStream, irq.ime);
+    state_put_u8(pStream, joypad.buttons);
+}
+
+/**
+ * Same layout as load_cpu(), the mode selects how cpu_run() goes on. The
+ * cycle count is returned for check_sched()
+ */
+static bool check_cpu(struct state_stream_t *pStream, uint32_t *pCycles)
+{
+    // AF, BC, DE, HL, SP, PC
+    pStream->offset += 6 * 2;
+
+    uint8_t mode = state_get_u8(pStream);
+    uint8_t idle_cycles = state_get_u8(pStream);
+    pStream->offset += 1; // cycle_counter
+    *pCycles = state_get_u32(pStream);
+
+    // prefix_cb, ime, buttons
+    pStream->offset += 1 + 1 + 1;
+
+    // Whole iterations of an idle loop are counted in idle_cycles
+    return (mode <= CPU_MODE_BREAK) && ((mode != CPU_MODE_IDLE_LOOP) || (idle_cycles > 0));
+}
+
+static void load_cpu(struct state_stream_t *pStream)
+{
+    // No pending lazy flags
+    memset(&cpu.reg, 0, sizeof(cpu.reg));
+
+    cpu.reg.AF = state_get_u16(pStream);
+    cpu.reg.BC = state_get_u16(pStream);
+    cpu.reg.DE = state_get_u16(pStream);
+    cpu.reg.HL = state_get_u16(pStream);
+    cpu.reg.SP = state_get_u16(pStream);
+    cpu.reg.PC = state_get_u16(pStream);
+
+    cpu.mode = state_get_u8(pStream);
+    cpu.idle_cycles = state_get_u8(pStream);
+    cpu.cycle_counter = state_get_u8(pStream);
+    cpu.cycles = state_get_u32(pStream);
+    cpu.prefix_cb = state_get_u8(pStream);
+
+    irq.ime = state_get_u8(pStream);
+    joypad.buttons = state_get_u8(pStream);
+}
+
+/**
+ * Pending events, timestamps are cycle counts of the saved CPU
+ */
+static void save_sched(struct state_stream_t *pStream)
+{
+    // Deadline of inactive events is meaningless
+    for (uint8_t i = 0 ; i < SCHED_EVENT_NB ; i++)
+    {
+        state_put_u8(pStream, sched.aEvent[i].active);
+        state_put_u32(pStream, sched.aEvent[i].active ? sched.aEvent[i].deadline : 0);
+    }
+
+    state_put_u32(pStream, sched.end);
+    state_put_u32(pStream, timer.div_base);
+    state_put_u32(pStream, timer.sync);
+}
+
+/**
+ * Same layout as load_sched(). States are saved between two sched_run(), the
+ * CPU at most an instruction past the end of the last one, with events
+ * pending in the next STATE_EVENT_DELAY_MAX cycles. Timestamps far from the
+ * CPU would run or catch up for billions of cycles
+ */
+static bool check_sched(struct state_stream_t *pStream, uint32_t Cycles)
+{
+    bool valid = true;
+
+    for (uint8_t i = 0 ; i < SCHED_EVENT_NB ; i++)
+    {
+        bool active = state_get_u8(pStream);
+        int32_t delay = state_get_u32(pStream) - Cycles;
+
+        if (active && ((delay < -PPU_FRAME_DURATION) || (delay > STATE_EVENT_DELAY_MAX)))
+            valid = false;
+    }
+
+    uint32_t end = state_get_u32(pStream);
+
+    // div_base, sync
+    pStream->offset += 4 + 4;
+
+    return valid && ((uint32_t) (Cycles - end) <= PPU_FRAME_DURATION);
+}
+
+static void load_sched(struct state_stream_t *pStream)
+{
+    // Loaded between two sched_run(), CPU loaded first
+    sched.current = SCHED_EVENT_NB;
+    sched.target = cpu.cycles;
+
+    for (uint8_t i = 0 ; i < SCHED_EVENT_NB ; i++)
+    {
+        bool active = state_get_u8(pStream);
+        uint32_t deadline = state_get_u32(pStream);
+
+        if (active)
+            sched_set_at(i, deadline);
+        else
+            sched_cancel(i);
+    }
+
+    sched.end = state_get_u32(pStream);
+    timer.div_base = state_get_u32(pStream);
+    timer.sync = state_get_u32(pStream);
+}
+
+/**
+ * Rendering progress, the registers are IO Ports
+ */
+static void save_ppu(struct state_stream_t *pStream)
+{
+    state_put_u8(pStream, ppu.state);
+    state_put_u8(pStream, ppu.state_counter);
+    state_put_u8(pStream, ppu.y);
+    state_put_u8(pStream, ppu.x);
+    state_put_u8(pStream, ppu.OAM_counter);
+    state_put_block(pStream, ppu.aOAM_visible, PPU_OAM_VISIBLE_MAX);
+    state_put_u8(pStream, ppu.window_y);
+    state_put_u32(pStream, ppu.frame_counter);
+}
+
+/**
+ * Same layout as load_ppu(), the position indexes the state durations and
+ * the framebuffer
+ */
+static bool check_ppu(struct state_stream_t *pStream)
+{
+    uint8_t state = state_get_u8(pStream);
+    uint8_t state_counter = state_get_u8(pStream);
+    uint8_t y = state_get_u8(pStream);
+    pStream->offset += 1; // x
+    uint8_t OAM_counter = state_get_u8(pStream);
+    const uint8_t *pOAMVisible = &pStream->pData[pStream->offset];
+
+    // aOAM_visible, window_y, frame_counter
+    pStream->offset += PPU_OAM_VISIBLE_MAX + 1 + 4;
+
+    return ppu_check_state(state, state_counter, y, OAM_counter, pOAMVisible);
+}
+
+static void load_ppu(struct state_stream_t *pStream)
+{
+    ppu.state = state_get_u8(pStream);
+    ppu.state_counter = state_get_u8(pStream);
+    ppu.y = state_get_u8(pStream);
+    ppu.x = state_get_u8(pStream);
+    ppu.OAM_counter = state_get_u8(pStream);
+    state_get_block(pStream, ppu.aOAM_visible, PPU_OAM_VISIBLE_MAX);
+    ppu.window_y = state_get_u8(pStream);
+    ppu.frame_counter = state_get_u32(pStream);
+}
+
+/**
+ * Fields the emulator indexes, divides or runs up to, all checked before
+ * anything is loaded
+ */
+static bool check(struct state_stream_t *pStream)
+{
+    uint32_t cycles;
+
+    // Cartridge checked by state_load(), then the controller registers
+    pStream->offset += 4 + 5;
+    if (!check_cpu(pStream, &cycles) || !check_sched(pStream, cycles))
+        return false;
+
+    return check_ppu(pStream) && mem_check_state(pStream);
+}
+
+static void save(struct state_stream_t *pStream)
+{
+    state_put_u32(pStream, STATE_MAGIC);
+    state_put_u16(pStream, STATE_VERSION);
+    state_put_u32(pStream, state_size());
+
+    save_mbc(pStream);
+    save_cpu(pStream);
+    save_sched(pStream);
+    save_ppu(pStream);
+    mem_save_state(pStream);
+}
+
+/**
+ * Size of a state of the cartridge running
+ */
+uint32_t state_size(void)
+{
+    // Counted without the header, which calls state_size()
+    struct state_stream_t stream = {NULL, STATE_HEADER_SIZE};
+
+    save_mbc(&stream);
+    save_cpu(&stream);
+    save_sched(&stream);
+    save_ppu(&stream);
+    mem_save_state(&stream);
+
+    return stream.offset;
+}
+
+/**
+ * Serialize the emulator in pBuffer, return the state size or 0 if Size is
+ * too small
+ */
+uint32_t state_save(uint8_t *pBuffer, uint32_t Size)
+{
+    struct state_stream_t stream = {pBuffer, 0};
+
+    if (Size < state_size())
+        return 0;
+
+    save(&stream);
+    return stream.offset;
+}
+
+/**
+ * Restore a state saved by state_save(), false if it is not a state of the
+ * cartridge running or if it is corrupt. The emulator is left unchanged in
+ * that case
+ */
+bool state_load(const uint8_t *pBuffer, uint32_t Size)
+{
+    // Only read
+    struct state_stream_t stream = {(uint8_t *) pBuffer, 0};
+    uint32_t size = state_size();
+
+    if (Size < size)
+        return false;
+
+    if ((state_get_u32(&stream) != STATE_MAGIC) || (state_get_u16(&stream) != STATE_VERSION) ||
+        (state_get_u32(&stream) != size))
+        return false;
+
+    if ((state_get_u8(&stream) != mbc.type) || (state_get_u16(&stream) != mbc.rom_bank_nb) ||
+        (state_get_u8(&stream) != mbc.ram_bank_nb))
+        return false;
+
+    // A corrupt state leaves the emulator unchanged
+    stream.offset = STATE_HEADER_SIZE;
+    if (!check(&stream))
+        return false;
+
+    stream.offset = STATE_HEADER_SIZE;
+    load_mbc(&stream);
+    load_cpu(&stream);
+    load_sched(&stream);
+    load_ppu(&stream);
+    mem_load_state(&stream);
+
+    // Everything derived from the registers and memory
+    for (int i = 0 ; i < PPU_PALETTE_NB ; i++)
+        ppu_update_palette(i);
+    tile_init();
+    idle_disarm();
+
+    return true;
+}
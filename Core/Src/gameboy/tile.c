@@ -0,0 +1,199 @@
+/*
+ * tile.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/tile.h>
+#include <gameboy/mem.h>
+#include <string.h>
+
+#if defined(TILE_DECODER_AVX2)
+#include <immintrin.h>
+#elif defined(TILE_DECODER_SSE2)
+#include <emmintrin.h>
+#elif defined(TILE_DECODER_NEON)
+#include <arm_neon.h>
+#elif defined(TILE_DECODER_DSP)
+#include <cmsis_compiler.h>
+#endif
+
+#define TILE_SIZE       16 // 8 rows of 2 bytes
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct tile_cache_t tile_cache;
+
+void tile_init(void)
+{
+    // VRAM content is unknown
+    memset(tile_cache.aDirty, 0xFF, sizeof(tile_cache.aDirty));
+}
+
+/**
+ * Reference decoder: 2 bytes per row (low bitplane, high bitplane) to 8
+ * color indexes, leftmost pixel (bit 7) first
+ */
+void tile_decode_rows_scalar(const uint8_t *pData, uint8_t *pIndex, uint16_t rows)
+{
+    for (uint16_t r = 0 ; r < rows ; r++, pData += 2, pIndex += TILE_WIDTH)
+    {
+        uint8_t lo = pData[0];
+        uint8_t hi = pData[1];
+
+        for (int i = 0 ; i < TILE_WIDTH ; i++)
+            pIndex[i] = ((lo >> (7 - i)) & 0x01) | (((hi >> (7 - i)) & 0x01) << 1);
+    }
+}
+
+#if defined(TILE_DECODER_SSE2) || defined(TILE_DECODER_AVX2)
+
+/**
+ * Two rows per 128 bits: each byte holds its bitplane byte, the bit of the
+ * pixel is tested with a per-lane mask
+ */
+static inline __m128i decode_2_rows(const uint8_t *pData)
+{
+    const __m128i bit = _mm_set1_epi64x(0x0102040810204080LL);
+    uint32_t data;
+
+    // lo0 hi0 lo1 hi1 -> 4 x lo0, 4 x hi0, 4 x lo1, 4 x hi1
+    memcpy(&data, pData, sizeof(data));
+    __m128i x = _mm_cvtsi32_si128(data);
+    x = _mm_unpacklo_epi8(x, x);
+    x = _mm_unpacklo_epi16(x, x);
+
+    __m128i lo = _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128i hi = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 1, 1));
+
+    lo = _mm_cmpeq_epi8(_mm_and_si128(lo, bit), bit);
+    hi = _mm_cmpeq_epi8(_mm_and_si128(hi, bit), bit);
+
+    return _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi8(0x01)), _mm_and_si128(hi, _mm_set1_epi8(0x02)));
+}
+
+#endif
+
+#if defined(TILE_DECODER_SWAR)
+
+/**
+ * One bit per byte, bit 7 in the first byte (little endian)
+ */
+static inline uint64_t spread_bits(uint8_t b)
+{
+    uint64_t x = (b * 0x0101010101010101ULL) & 0x0102040810204080ULL;
+
+    // Non zero bytes to 0x80 and above, no carry between bytes
+    return ((x + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+#endif
+
+#if defined(TILE_DECODER_DSP)
+
+/**
+ * Four pixels: mask selects their bits in each byte, UADD8 sets GE for the
+ * non zero bytes and SEL picks the color index bit accordingly
+ */
+static inline uint32_t decode_4_pixels(uint8_t lo, uint8_t hi, uint32_t mask)
+{
+    uint32_t index;
+
+    __UADD8((lo * 0x01010101UL) & mask, 0xFFFFFFFFUL);
+    index = __SEL(0x01010101UL, 0x00000000UL);
+    __UADD8((hi * 0x01010101UL) & mask, 0xFFFFFFFFUL);
+    index |= __SEL(0x02020202UL, 0x00000000UL);
+
+    return index;
+}
+
+#endif
+
+void tile_decode_rows(const uint8_t *pData, uint8_t *pIndex, uint16_t rows)
+{
+#if defined(TILE_DECODER_AVX2)
+    // Four rows per 256 bits, bitplane bytes broadcast to their row by a
+    // shuffle (both 128 bits lanes hold the 8 bytes of data)
+    const __m256i bit = _mm256_set1_epi64x(0x0102040810204080LL);
+    const __m256i lo_byte = _mm256_set_epi64x(0x0606060606060606LL, 0x0404040404040404LL,
+                                              0x0202020202020202LL, 0x0000000000000000LL);
+    const __m256i hi_byte = _mm256_add_epi8(lo_byte, _mm256_set1_epi8(0x01));
+
+    for ( ; rows >= 4 ; rows -= 4, pData += 8, pIndex += 4 * TILE_WIDTH)
+    {
+        __m256i data = _mm256_broadcastsi128_si256(_mm_loadl_epi64((const __m128i *) pData));
+        __m256i lo = _mm256_shuffle_epi8(data, lo_byte);
+        __m256i hi = _mm256_shuffle_epi8(data, hi_byte);
+
+        lo = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lo, bit), bit), _mm256_set1_epi8(0x01));
+        hi = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hi, bit), bit), _mm256_set1_epi8(0x02));
+
+        _mm256_storeu_si256((__m256i *) pIndex, _mm256_or_si256(lo, hi));
+    }
+
+    for ( ; rows >= 2 ; rows -= 2, pData += 4, pIndex += 2 * TILE_WIDTH)
+        _mm_storeu_si128((__m128i *) pIndex, decode_2_rows(pData));
+
+    tile_decode_rows_scalar(pData, pIndex, rows);
+
+#elif defined(TILE_DECODER_SSE2)
+    for ( ; rows >= 2 ; rows -= 2, pData += 4, pIndex += 2 * TILE_WIDTH)
+        _mm_storeu_si128((__m128i *) pIndex, decode_2_rows(pData));
+
+    tile_decode_rows_scalar(pData, pIndex, rows);
+
+#elif defined(TILE_DECODER_NEON)
+    const uint8x16_t bit = vreinterpretq_u8_u64(vdupq_n_u64(0x0102040810204080ULL));
+
+    for ( ; rows >= 2 ; rows -= 2, pData += 4, pIndex += 2 * TILE_WIDTH)
+    {
+        uint8x16_t lo = vcombine_u8(vdup_n_u8(pData[0]), vdup_n_u8(pData[2]));
+        uint8x16_t hi = vcombine_u8(vdup_n_u8(pData[1]), vdup_n_u8(pData[3]));
+
+        lo = vandq_u8(vtstq_u8(lo, bit), vdupq_n_u8(0x01));
+        hi = vandq_u8(vtstq_u8(hi, bit), vdupq_n_u8(0x02));
+
+        vst1q_u8(pIndex, vorrq_u8(lo, hi));
+    }
+
+    tile_decode_rows_scalar(pData, pIndex, rows);
+
+#elif defined(TILE_DECODER_DSP)
+    for ( ; rows > 0 ; rows--, pData += 2, pIndex += TILE_WIDTH)
+    {
+        uint32_t left = decode_4_pixels(pData[0], pData[1], 0x10204080UL);
+        uint32_t right = decode_4_pixels(pData[0], pData[1], 0x01020408UL);
+
+        memcpy(&pIndex[0], &left, 4);
+        memcpy(&pIndex[4], &right, 4);
+    }
+
+#elif defined(TILE_DECODER_SWAR)
+    for ( ; rows > 0 ; rows--, pData += 2, pIndex += TILE_WIDTH)
+    {
+        uint64_t index = spread_bits(pData[0]) | (spread_bits(pData[1]) << 1);
+        memcpy(pIndex, &index, TILE_WIDTH);
+    }
+
+#else
+    tile_decode_rows_scalar(pData, pIndex, rows);
+#endif
+}
+
+/**
+ * Decode a dirty row from VRAM, or the whole tile when all its rows are dirty
+ */
+void tile_update(uint16_t tile, uint8_t row)
+{
+    const uint8_t *pVRAM = mem_get_vram();
+
+    if (tile_cache.aDirty[tile] == 0xFF)
+    {
+        tile_decode_rows(&pVRAM[tile * TILE_SIZE], tile_cache.aIndex[tile][0], TILE_ROW_NB);
+        tile_cache.aDirty[tile] = 0x00;
+        return;
+    }
+
+    tile_decode_rows(&pVRAM[tile * TILE_SIZE + row * 2], tile_cache.aIndex[tile][row], 1);
+    tile_cache.aDirty[tile] &= ~(1 << row);
+}
@@ -0,0 +1,175 @@
+/*
+ * timer.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <gameboy/timer.h>
+#include <gameboy/cpu.h>
+#include <gameboy/irq.h>
+#include <gameboy/mem.h>
+#include <gameboy/sched.h>
+#include <stddef.h>
+
+// Exported to be use directly
+GAMEBOY_CONTEXT struct timer_t timer;
+
+// TIMA period in cycles, log2, from TAC clock select
+static const uint8_t aPeriodShift[4] = {8, 2, 4, 6};
+
+static inline uint32_t get_divider(void)
+{
+    return cpu.cycles - timer.div_base;
+}
+
+/**
+ * Divider bit whose falling edges clock TIMA, 0 when stopped
+ */
+static inline uint32_t get_tima_bit(void)
+{
+    if (!timer.pReg->TAC_Flags.Enable)
+        return 0;
+
+    return get_divider() & (1 << (aPeriodShift[timer.pReg->TAC_Flags.Clock] - 1));
+}
+
+/**
+ * Add ticks to TIMA, reloaded with TMA on each overflow. Overflows after the
+ * first one only request the same IRQ again, whatever the ticks count
+ */
+static void increment(uint32_t ticks)
+{
+    uint32_t step = 0x100 - timer.pReg->TIMA;
+
+    if (ticks < step)
+    {
+        timer.pReg->TIMA += ticks;
+        return;
+    }
+
+    timer.pReg->TIMA = timer.pReg->TMA + (ticks - step) % (0x100 - timer.pReg->TMA);
+    irq_request(IRQ_MASK_TIMER);
+}
+
+/**
+ * Bring TIMA up to date: count the periods ended since the last sync
+ */
+static void sync(void)
+{
+    if (timer.pReg->TAC_Flags.Enable)
+    {
+        uint8_t shift = aPeriodShift[timer.pReg->TAC_Flags.Clock];
+        uint32_t last = (timer.sync - timer.div_base) & ~((1 << shift) - 1);
+
+        increment((get_divider() - last) >> shift);
+    }
+
+    timer.sync = cpu.cycles;
+}
+
+/**
+ * Schedule the next TIMA overflow, from the last sync
+ */
+static void schedule(void)
+{
+    if (!timer.pReg->TAC_Flags.Enable)
+    {
+        sched_cancel(SCHED_EVENT_TIMER);
+        return;
+    }
+
+    uint8_t shift = aPeriodShift[timer.pReg->TAC_Flags.Clock];
+    uint32_t last = (timer.sync - timer.div_base) & ~((1 << shift) - 1);
+    uint32_t ticks = 0x100 - timer.pReg->TIMA;
+
+    sched_set_at(SCHED_EVENT_TIMER, timer.div_base + last + (ticks << shift));
+}
+
+static void timer_event(void)
+{
+    sync();
+    schedule();
+}
+
+static uint8_t io_read_div(uint16_t Addr)
+{
+    (void) Addr;
+    return get_divider() >> TIMER_DIV_SHIFT;
+}
+
+static uint8_t io_read_tima(uint16_t Addr)
+{
+    (void) Addr;
+    sync();
+    return timer.pReg->TIMA;
+}
+
+/**
+ * DIV: reset on write, TIMA ticks if its divider bit was set
+ */
+static void io_write_div(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+    (void) Value;
+
+    sync();
+    if (get_tima_bit())
+        increment(1);
+
+    timer.div_base = cpu.cycles;
+    schedule();
+}
+
+static void io_write_tima(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+
+    sync();
+    timer.pReg->TIMA = Value;
+    schedule();
+}
+
+static void io_write_tma(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+
+    // Overflows up to now reload the previous value
+    sync();
+    timer.pReg->TMA = Value;
+}
+
+/**
+ * TAC: TIMA ticks when its clock goes from set to cleared or stopped
+ */
+static void io_write_tac(uint16_t Addr, uint8_t Value)
+{
+    (void) Addr;
+
+    sync();
+    bool bit = get_tima_bit();
+
+    timer.pReg->TAC = 0xF8 | Value;
+    if (bit && !get_tima_bit())
+        increment(1);
+
+    schedule();
+}
+
+void timer_init(void)
+{
+    timer.pReg = (struct timer_reg_t *) mem_get_register(TIMER);
+    timer.pReg->DIV = 0x00;
+    timer.pReg->TIMA = 0x00;
+    timer.pReg->TMA = 0x00;
+    timer.pReg->TAC = 0xF8;
+    timer.div_base = cpu.cycles;
+    timer.sync = cpu.cycles;
+
+    mem_register_io(0xFF04, io_read_div, io_write_div);
+    mem_register_io(0xFF05, io_read_tima, io_write_tima);
+    mem_register_io(0xFF06, NULL, io_write_tma);
+    mem_register_io(0xFF07, NULL, io_write_tac);
+
+    sched_register(SCHED_EVENT_TIMER, timer_event);
+}
@@ -25,10 +25,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "stm32f429i_discovery_lcd.h"
-#include <gameboy/cpu.h>
-#include <gameboy/irq.h>
-#include <gameboy/mem.h>
-#include <gameboy/ppu.h>
+#include <gameboy/gameboy.h>
+#include <gameboy/sched.h>
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -38,6 +36,12 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define CPU_RUN_BUDGET  114 // One scanline
+
+// ROM images flashed in bank 2
+#define BOOTROM_ADDR    ((uint8_t *) 0x08100000)
+#define CARTRIDGE_ADDR  ((uint8_t *) 0x08110000)
+#define CARTRIDGE_SIZE  0xF0000 // Up to the end of flash
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -126,10 +130,7 @@ int main(void)
   MX_USART1_UART_Init();
   MX_USB_HOST_Init();
   /* USER CODE BEGIN 2 */
-  cpu_init();
-  irq_init();
-  mem_init();
-  ppu_init();
+  gameboy_init(BOOTROM_ADDR, CARTRIDGE_ADDR, CARTRIDGE_SIZE);
 
   BSP_LCD_Init();
   /* Layer2 Init */
@@ -161,9 +162,8 @@ int main(void)
     /* USER CODE BEGIN 3 */
 	  HAL_GPIO_TogglePin(LD3_GPIO_Port, LD3_Pin);
 
-	  // Emulation cycle
-	  cpu_exec();
-	  ppu_exec();
+	  // Emulation of a batch of cycles, CPU runs until the next event
+	  sched_run(CPU_RUN_BUDGET);
 
 	  HAL_Delay(50);
   }
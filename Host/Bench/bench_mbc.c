@@ -0,0 +1,202 @@
+/*
+ * bench_mbc.c
+ *
+ *  Host bank switching benchmark: checks the banks mapped by MBC1, MBC3 and
+ *  MBC5 register writes on a 2 MiB ROM, then measures the cost of a bank
+ *  switch through mem_write_u8() and within an emulated program switching
+ *  bank on every iteration. A 16 kiB bank copy is given for comparison.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/cpu.h>
+#include <gameboy/mbc.h>
+#include <gameboy/mem.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROM_BANK_NB         128
+#define ROM_BANK_SIZE       16384
+#define RAM_BANK_SIZE       8192
+
+#define BENCH_SWITCHES      10000000
+#define BENCH_FRAMES        600
+#define BENCH_LOOP_CYCLES   11      // INC C; LD A,C; LD (2000),A; LD A,(HL); JR
+
+#define ROM_ENTRY           0x0100
+
+struct cartridge_t
+{
+    const char *pName;
+    uint8_t type;       // Header 0x0147
+    uint8_t ram_size;   // Header 0x0149
+    uint16_t bank_mask; // Banks reachable through the low bank register
+};
+
+static const struct cartridge_t aCartridge[] =
+{
+    {"mbc1",    0x03,   0x03,   0x1F},
+    {"mbc3",    0x13,   0x03,   0x7F},
+    {"mbc5",    0x1B,   0x04,   0x1FF},
+};
+
+static uint8_t aROM[ROM_BANK_NB * ROM_BANK_SIZE];
+
+// loop: INC C; LD A,C; LD (2000),A; LD A,(HL); JR loop
+static const uint8_t aProgram[] =
+{
+    0x21, 0x00, 0x40,
+    0x0C, 0x79, 0xEA, 0x00, 0x20, 0x7E, 0x18, 0xF9,
+};
+
+/**
+ * Every bank starts with its number, the program is in bank 0
+ */
+static void setup(const struct cartridge_t *pCartridge)
+{
+    for (uint32_t bank = 0 ; bank < ROM_BANK_NB ; bank++)
+        aROM[bank * ROM_BANK_SIZE] = bank;
+
+    memcpy(&aROM[ROM_ENTRY], aProgram, sizeof(aProgram));
+    aROM[0x0147] = pCartridge->type;
+    aROM[0x0148] = 0x06; // 2 MiB
+    aROM[0x0149] = pCartridge->ram_size;
+
+    gameboy_init(NULL, aROM, sizeof(aROM));
+}
+
+static uint16_t expected_bank(const struct cartridge_t *pCartridge, uint16_t value)
+{
+    uint16_t bank = value & pCartridge->bank_mask;
+
+    if ((bank == 0) && (pCartridge->type != 0x1B))
+        bank = 1;
+
+    return bank % ROM_BANK_NB;
+}
+
+static int check(const struct cartridge_t *pCartridge)
+{
+    setup(pCartridge);
+
+    for (uint16_t value = 0 ; value < 0x200 ; value++)
+    {
+        mem_write_u8(0x2000, value & 0xFF);
+        if (pCartridge->type == 0x1B)
+            mem_write_u8(0x3000, value >> 8);
+
+        if (mem_read_u8(0x4000) != expected_bank(pCartridge, value))
+            return -1;
+    }
+
+    // MBC1: bits 5-6 of the ROM bank, also applied to bank 0 in mode 1
+    if (pCartridge->type == 0x03)
+    {
+        mem_write_u8(0x2000, 0x00);
+        mem_write_u8(0x4000, 0x01);
+        if (mem_read_u8(0x4000) != 0x21)
+            return -1;
+
+        mem_write_u8(0x6000, 0x01);
+        if (mem_read_u8(0x0000) != 0x20)
+            return -1;
+
+        mem_write_u8(0x4000, 0x00);
+        mem_write_u8(0x6000, 0x00);
+    }
+
+    // RAM: disabled, then one value per bank
+    if (mem_read_u8(0xA000) != 0xFF)
+        return -1;
+
+    mem_write_u8(0x0000, 0x0A);
+    for (uint8_t bank = 0 ; bank < mbc.ram_bank_nb ; bank++)
+    {
+        mem_write_u8(0x4000, bank);
+        mem_write_u8(0x6000, 0x01); // MBC1 RAM banking
+        mem_write_u8(0xA000 + bank, 0x80 | bank);
+    }
+
+    for (uint8_t bank = 0 ; bank < mbc.ram_bank_nb ; bank++)
+    {
+        mem_write_u8(0x4000, bank);
+        if (mem_read_u8(0xA000 + bank) != (0x80 | bank))
+            return -1;
+    }
+
+    mem_write_u8(0x0000, 0x00);
+    if (mem_read_u8(0xA000) != 0xFF)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * Nanoseconds per bank switch through mem_write_u8()
+ */
+static double bench_switch(const struct cartridge_t *pCartridge)
+{
+    volatile uint8_t sum = 0;
+
+    setup(pCartridge);
+    double t0 = host_time();
+
+    for (uint32_t i = 0 ; i < BENCH_SWITCHES ; i++)
+    {
+        mem_write_u8(0x2000, i);
+        sum += mem_read_u8(0x4000);
+    }
+
+    return (host_time() - t0) * 1e9 / BENCH_SWITCHES;
+}
+
+/**
+ * Emulated bank switches per second
+ */
+static double bench_program(const struct cartridge_t *pCartridge)
+{
+    setup(pCartridge);
+    uint32_t start = cpu.cycles;
+    double t0 = host_time();
+
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        gameboy_run_frame();
+
+    return (double) (cpu.cycles - start) / BENCH_LOOP_CYCLES / (host_time() - t0);
+}
+
+static double bench_copy(void)
+{
+    static uint8_t aBank[ROM_BANK_SIZE];
+    uint32_t loops = 20000;
+    double t0 = host_time();
+
+    for (uint32_t i = 0 ; i < loops ; i++)
+    {
+        memcpy(aBank, &aROM[(i % ROM_BANK_NB) * ROM_BANK_SIZE], ROM_BANK_SIZE);
+        __asm__ volatile("" : : "r" (aBank) : "memory");
+    }
+
+    return (host_time() - t0) * 1e9 / loops;
+}
+
+int main(void)
+{
+    for (size_t i = 0 ; i < sizeof(aCartridge) / sizeof(aCartridge[0]) ; i++)
+    {
+        if (check(&aCartridge[i]) != 0)
+        {
+            printf("%s: wrong bank mapped\n", aCartridge[i].pName);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("mbc    ns/switch  emulated switches/s\n");
+    for (size_t i = 0 ; i < sizeof(aCartridge) / sizeof(aCartridge[0]) ; i++)
+        printf("%-5s  %9.2f  %19.0f\n", aCartridge[i].pName, bench_switch(&aCartridge[i]), bench_program(&aCartridge[i]));
+
+    printf("copy of a 16 kiB bank: %.0f ns\n", bench_copy());
+
+    return EXIT_SUCCESS;
+}
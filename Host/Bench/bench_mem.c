@@ -0,0 +1,94 @@
+/*
+ * bench_mem.c
+ *
+ *  Host micro-benchmark of mem_read_u8 / mem_write_u8 throughput, and of an
+ *  OAM DMA transfer against the 160 mem_read_u8() it replaces.
+ */
+
+#include <gameboy/mem.h>
+#include <host.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BENCH_LOOPS     2000
+
+/**
+ * Read every byte of [Start - End[ BENCH_LOOPS times
+ */
+static void bench_read(const char *pName, uint16_t Start, uint32_t End)
+{
+    volatile uint8_t sink = 0;
+    uint8_t acc = 0;
+    double t0 = host_time();
+
+    for (int loop = 0 ; loop < BENCH_LOOPS ; loop++)
+        for (uint32_t addr = Start ; addr < End ; addr++)
+            acc += mem_read_u8(addr);
+
+    double t = host_time() - t0;
+    sink = acc;
+    (void) sink;
+
+    printf("read  %-6s %8.1f Mreads/s\n", pName, (double) (End - Start) * BENCH_LOOPS / t / 1e6);
+}
+
+static void bench_write(const char *pName, uint16_t Start, uint32_t End)
+{
+    double t0 = host_time();
+
+    for (int loop = 0 ; loop < BENCH_LOOPS ; loop++)
+        for (uint32_t addr = Start ; addr < End ; addr++)
+            mem_write_u8(addr, addr + loop);
+
+    double t = host_time() - t0;
+
+    printf("write %-6s %8.1f Mwrites/s\n", pName, (double) (End - Start) * BENCH_LOOPS / t / 1e6);
+}
+
+/**
+ * OAM DMA from SRAM: bulk copy, then page tables blocked. Without scheduler
+ * the transfer never ends, each one restarts the previous: last benchmark
+ */
+static void bench_dma(void)
+{
+    volatile uint8_t sink = 0;
+    uint8_t acc = 0;
+    uint32_t loops = BENCH_LOOPS * 100;
+    double t0 = host_time();
+
+    for (uint32_t loop = 0 ; loop < loops ; loop++)
+        for (uint16_t i = 0 ; i < 160 ; i++)
+            acc += mem_read_u8(0xC000 + i);
+
+    double t_read = host_time() - t0;
+    sink = acc;
+    (void) sink;
+
+    t0 = host_time();
+    for (uint32_t loop = 0 ; loop < loops ; loop++)
+        mem_write_u8(0xFF46, 0xC0);
+
+    double t_dma = host_time() - t0;
+
+    printf("dma   %8.1f ns/transfer (160 reads: %.1f ns)\n", t_dma * 1e9 / loops, t_read * 1e9 / loops);
+}
+
+int main(void)
+{
+    mem_init(NULL, NULL, 0);
+
+    // Cartridge ROM is not available on host, only RAM areas are exercised
+    bench_write("VRAM", 0x8000, 0xA000);
+    bench_write("SRAM", 0xC000, 0xE000);
+    bench_write("HRAM", 0xFF80, 0xFFFF);
+
+    bench_read("VRAM", 0x8000, 0xA000);
+    bench_read("SRAM", 0xC000, 0xE000);
+    bench_read("Echo", 0xE000, 0xFE00);
+    bench_read("HRAM", 0xFF80, 0x10000);
+
+    bench_dma();
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * bench_output.c
+ *
+ *  Host benchmark of the framebuffer output formats: footprint, bytes
+ *  written per frame and per second at 59.73 Hz, and rendering time of the
+ *  PPU workload of bench_suite. Each format is checked against L8 first.
+ *  The "stream" row feeds a line sink summing the shades, without buffer.
+ *  The "hash" row only hashes the frames (ppu_set_frame_hash()), checked
+ *  against the hash of the L8 framebuffer.
+ *
+ *  On target, the LTDC reads the whole framebuffer on every refresh too, so
+ *  the SDRAM traffic scales with the same bytes per pixel.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/ppu.h>
+#include <bench.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_FRAMES    600
+
+// bench() modes besides the formats
+#define BENCH_NO_OUTPUT PPU_FORMAT_NB
+#define BENCH_STREAM    (PPU_FORMAT_NB + 1)
+#define BENCH_HASH      (PPU_FORMAT_NB + 2)
+
+static const char *apFormatName[PPU_FORMAT_NB] =
+{
+    [PPU_FORMAT_L8]         = "l8",
+    [PPU_FORMAT_2BPP]       = "2bpp",
+    [PPU_FORMAT_RGB565]     = "rgb565",
+    [PPU_FORMAT_ARGB8888]   = "argb8888",
+};
+
+static uint8_t aROM[BENCH_ROM_SIZE];
+static uint32_t aFramebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+static ppu_pixel_t aReference[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+static uint32_t stream_sum;
+
+// loop: NOP; JR loop
+static const uint8_t aProgram[] =
+{
+    0x00, 0x18, 0xFD,
+};
+
+static void stream_sink(uint8_t ly, const ppu_pixel_t *pLine)
+{
+    (void) ly;
+
+    for (int x = 0 ; x < PPU_SCREEN_WIDTH ; x++)
+        stream_sum += pLine[x];
+}
+
+/**
+ * NOP loop, every sprite visible and all layers enabled
+ */
+static void setup(enum ppu_format_t format)
+{
+    bench_load_program(aROM, sizeof(aROM), aProgram, sizeof(aProgram));
+
+    gameboy_init(NULL, aROM, sizeof(aROM));
+    ppu_set_framebuffer(aFramebuffer, format);
+    ppu_set_frame_hash(false);
+    bench_setup_scene(BENCH_OAM);
+}
+
+static uint8_t get_shade(enum ppu_format_t format, uint32_t i)
+{
+    switch (format)
+    {
+        case PPU_FORMAT_L8:
+            return ((uint8_t *) aFramebuffer)[i];
+
+        case PPU_FORMAT_2BPP:
+            return (((uint8_t *) aFramebuffer)[i / 4] >> ((3 - i % 4) * 2)) & 0x03;
+
+        case PPU_FORMAT_RGB565:
+            for (uint8_t shade = 0 ; shade < 4 ; shade++)
+                if (((uint16_t *) aFramebuffer)[i] == ppu.aPixel[shade])
+                    return shade;
+            return 0xFF;
+
+        default:
+            for (uint8_t shade = 0 ; shade < 4 ; shade++)
+                if (aFramebuffer[i] == ppu.aColor[shade])
+                    return shade;
+            return 0xFF;
+    }
+}
+
+static int check(enum ppu_format_t format)
+{
+    setup(format);
+    gameboy_run_frame();
+    gameboy_run_frame();
+
+    for (uint32_t i = 0 ; i < PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT ; i++)
+    {
+        uint8_t shade = get_shade(format, i);
+
+        if (format == PPU_FORMAT_L8)
+            aReference[i] = shade;
+        else if (shade != aReference[i])
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Frame hash as lines are rendered, against a hash of the framebuffer
+ */
+static int check_hash(void)
+{
+    struct hash_stream_t stream;
+
+    setup(PPU_FORMAT_L8);
+    ppu_set_frame_hash(true);
+    gameboy_run_frame();
+    gameboy_run_frame();
+
+    hash_stream_init(&stream);
+    hash_stream_update(&stream, aFramebuffer, PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT);
+
+    return (hash_stream_digest(&stream) == ppu.frame_hash) ? 0 : -1;
+}
+
+/**
+ * Frames per second of a format, BENCH_NO_OUTPUT, BENCH_STREAM or BENCH_HASH
+ */
+static double bench(int mode)
+{
+    double best = 0;
+
+    for (int run = 0 ; run < BENCH_RUNS ; run++)
+    {
+        setup(mode < PPU_FORMAT_NB ? mode : PPU_FORMAT_L8);
+        if (mode == BENCH_NO_OUTPUT)
+            ppu_set_framebuffer(NULL, PPU_FORMAT_L8);
+        else if (mode == BENCH_STREAM)
+            ppu_set_line_sink(stream_sink);
+        else if (mode == BENCH_HASH)
+        {
+            ppu_set_framebuffer(NULL, PPU_FORMAT_L8);
+            ppu_set_frame_hash(true);
+        }
+
+        double t0 = host_time();
+        for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+            gameboy_run_frame();
+
+        double fps = BENCH_FRAMES / (host_time() - t0);
+        if (fps > best)
+            best = fps;
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    for (int format = 0 ; format < PPU_FORMAT_NB ; format++)
+    {
+        if (check(format) != 0)
+        {
+            printf("%s: output differs from l8\n", apFormatName[format]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (check_hash() != 0)
+    {
+        printf("hash: differs from the framebuffer hash\n");
+        return EXIT_FAILURE;
+    }
+
+    // Emulation without rendering, to isolate the rendering cost
+    double no_output = bench(BENCH_NO_OUTPUT);
+    double stream = bench(BENCH_STREAM);
+    double hash = bench(BENCH_HASH);
+
+    printf("format    bytes    bytes/frame  KB/s @59.73Hz  frames/s  render us/frame\n");
+    printf("none      %5u    %11u  %13s  %8.0f\n", 0, 0, "-", no_output);
+    printf("stream    %5u    %11u  %13s  %8.0f  %15.2f\n", 0, 0, "-", stream, (1 / stream - 1 / no_output) * 1e6);
+    printf("hash      %5u    %11u  %13s  %8.0f  %15.2f\n", 0, 0, "-", hash, (1 / hash - 1 / no_output) * 1e6);
+    for (int format = 0 ; format < PPU_FORMAT_NB ; format++)
+    {
+        uint32_t size = ppu_framebuffer_size(format);
+        double fps = bench(format);
+
+        // Every line is written once per frame
+        printf("%-8s  %5u    %11u  %13.1f  %8.0f  %15.2f\n", apFormatName[format], size, size,
+               size * PPU_FRAME_RATE / 1024, fps, (1 / fps - 1 / no_output) * 1e6);
+    }
+
+    return EXIT_SUCCESS;
+}
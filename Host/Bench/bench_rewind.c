@@ -0,0 +1,162 @@
+/*
+ * bench_rewind.c
+ *
+ *  Host rewind benchmark: a game-like workload (sprite table moved in SRAM
+ *  and copied by OAM DMA on V-Blank, timer IRQ) captured in a 1 MiB arena. Every snapshot left in the
+ *  ring is checked against a full copy while rewinding to the oldest one.
+ *  Prints the snapshots held, the seconds of rewind and the footprint, and
+ *  the capture cost against the emulation time of a frame and against the
+ *  59.73 Hz frame period, for several intervals.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/rewind.h>
+#include <gameboy/state.h>
+#include <bench.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_FRAMES    3600    // 60 s of emulated time
+
+#define ARENA_SIZE      (1024 * 1024)
+
+static uint8_t aROM[BENCH_ROM_SIZE];
+static uint8_t aArena[ARENA_SIZE];
+static ppu_pixel_t aFramebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+
+// EI; main: HALT; LD HL,C001; LD B,28
+// loop: INC (HL); INC L; INC L; INC L; INC L; DEC B; JR NZ,loop; JR main
+static const uint8_t aProgram[] =
+{
+    0xFB, 0x76, 0x21, 0x01, 0xC0, 0x06, 0x28,
+    0x34, 0x2C, 0x2C, 0x2C, 0x2C, 0x05, 0x20, 0xF8, 0x18, 0xF0,
+};
+
+static const uint8_t aInterval[] = {1, 2, 4};
+
+/**
+ * Sprite table in C000, V-Blank IRQ: OAM DMA. Timer IRQ every 1024 cycles
+ */
+static void setup(void)
+{
+    bench_load_program(aROM, sizeof(aROM), aProgram, sizeof(aProgram));
+    bench_load_vblank_dma(aROM);
+
+    gameboy_init(NULL, aROM, sizeof(aROM));
+    ppu_set_framebuffer(aFramebuffer, PPU_FORMAT_L8);
+    bench_setup_scene(BENCH_SRAM);
+    bench_setup_dma();
+    bench_setup_timer();
+    mem_write_u8(0xFFFF, 0x05); // IE: V-Blank, Timer
+}
+
+/**
+ * Rewind through every snapshot held, each one compared with its full copy
+ */
+static int check(uint8_t interval)
+{
+    uint32_t size;
+    uint32_t count = BENCH_FRAMES / interval;
+    uint8_t *pCopies;
+
+    setup();
+    size = state_size();
+    pCopies = malloc((size_t) count * size);
+    if ((NULL == pCopies) || !rewind_init(aArena, sizeof(aArena), interval))
+    {
+        free(pCopies);
+        return -1;
+    }
+
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+    {
+        gameboy_run_frame();
+        rewind_frame();
+        if ((i + 1) % interval == 0)
+            state_save(&pCopies[(size_t) ((i + 1) / interval - 1) * size], size);
+    }
+
+    uint8_t *pState = malloc(size);
+    uint32_t snapshot = count;
+    int result = (rewind_ring.snapshot_nb > 0) ? 0 : -1;
+
+    while ((result == 0) && rewind_back())
+    {
+        state_save(pState, size);
+        if (memcmp(pState, &pCopies[(size_t) --snapshot * size], size) != 0)
+            result = -1;
+    }
+
+    // Emulation goes on from the oldest snapshot
+    gameboy_run_frame();
+
+    free(pState);
+    free(pCopies);
+    return result;
+}
+
+/**
+ * Seconds spent in frames and in captures over BENCH_FRAMES
+ */
+static void bench(uint8_t interval, double *pFrame, double *pCapture)
+{
+    for (int run = 0 ; run < BENCH_RUNS ; run++)
+    {
+        double frame = 0;
+        double capture = 0;
+
+        setup();
+        rewind_init(aArena, sizeof(aArena), interval);
+
+        for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        {
+            double t0 = host_time();
+            gameboy_run_frame();
+            double t1 = host_time();
+            rewind_frame();
+            frame += t1 - t0;
+            capture += host_time() - t1;
+        }
+
+        if ((run == 0) || (frame + capture < *pFrame + *pCapture))
+        {
+            *pFrame = frame;
+            *pCapture = capture;
+        }
+    }
+}
+
+int main(void)
+{
+    printf("arena: %u bytes\n", ARENA_SIZE);
+    printf("interval  snapshots  rewind s  bytes/delta  footprint  frame us  capture us  %% emulated  %% 59.73Hz\n");
+
+    for (size_t i = 0 ; i < sizeof(aInterval) ; i++)
+    {
+        uint8_t interval = aInterval[i];
+
+        if (check(interval) != 0)
+        {
+            printf("interval %u: snapshot restored differs\n", interval);
+            return EXIT_FAILURE;
+        }
+
+        double frame = 0, capture = 0;
+        bench(interval, &frame, &capture);
+
+        // Per frame, captures are spread over interval frames
+        uint32_t snapshots = rewind_ring.snapshot_nb;
+        frame /= BENCH_FRAMES;
+        capture /= BENCH_FRAMES;
+
+        printf("%8u  %9u  %8.1f  %11u  %9u  %8.2f  %10.2f  %10.2f  %9.3f\n", interval, snapshots,
+               snapshots * interval / PPU_FRAME_RATE, rewind_ring.used / snapshots - 8, rewind_footprint(),
+               frame * 1e6, capture * 1e6, capture * 100 / frame, capture * 100 * PPU_FRAME_RATE);
+    }
+
+    return EXIT_SUCCESS;
+}
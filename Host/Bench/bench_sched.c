@@ -0,0 +1,79 @@
+/*
+ * bench_sched.c
+ *
+ *  Host benchmark of emulated frames per second with the per-cycle loop,
+ *  the batched loop and the event scheduler.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/cpu.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/sched.h>
+#include <stddef.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define BENCH_FRAMES    600 // 10 s of emulated time
+#define BENCH_BATCH     114 // One scanline
+
+// INC A; DEC B; JR -4
+static const uint8_t aProgram[] = {0x3C, 0x05, 0x18, 0xFC};
+
+static void reset(void)
+{
+    gameboy_init(NULL, NULL, 0);
+
+    // Cartridge ROM is not available on host, run from SRAM
+    for (uint16_t i = 0 ; i < sizeof(aProgram) ; i++)
+        mem_write_u8(0xC000 + i, aProgram[i]);
+    cpu.reg.PC = 0xC000;
+}
+
+static void run_per_cycle(void)
+{
+    for (uint32_t i = 0 ; i < BENCH_FRAMES * PPU_FRAME_DURATION ; i++)
+    {
+        cpu_exec();
+        ppu_exec();
+    }
+}
+
+static void run_batch(void)
+{
+    uint32_t cycles = 0;
+
+    while (cycles < BENCH_FRAMES * PPU_FRAME_DURATION)
+    {
+        uint32_t step = cpu_run(BENCH_BATCH);
+        ppu_run(step);
+        cycles += step;
+    }
+}
+
+static void run_sched(void)
+{
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        sched_run(PPU_FRAME_DURATION);
+}
+
+static void bench(const char *pName, void (*run)(void))
+{
+    reset();
+
+    double t0 = host_time();
+    run();
+    double t = host_time() - t0;
+
+    printf("%-10s %8.1f frames/s\n", pName, BENCH_FRAMES / t);
+}
+
+int main(void)
+{
+    bench("per-cycle", run_per_cycle);
+    bench("batch", run_batch);
+    bench("scheduler", run_sched);
+
+    return 0;
+}
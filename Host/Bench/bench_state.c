@@ -0,0 +1,115 @@
+/*
+ * bench_state.c
+ *
+ *  Host save state benchmark: checks that a state loaded runs exactly as the
+ *  emulator it was saved from (same state and frame after 60 frames), then
+ *  measures state_save() and state_load() on an MBC5 cartridge with 32 kiB
+ *  of RAM, while the PPU, the timer and bank switching are running.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/state.h>
+#include <bench.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_LOOPS     10000
+#define BENCH_FRAMES    60
+
+#define ROM_SIZE        0x10000 // 4 banks
+#define STATE_SIZE_MAX  0x10000
+
+static uint8_t aROM[ROM_SIZE];
+static uint8_t aState[3][STATE_SIZE_MAX];
+static ppu_pixel_t aFramebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+static ppu_pixel_t aReference[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+
+// LD A,0A; LD (0000),A; EI
+// start: LD HL,C000; LD DE,A000; LD B,0
+// loop: LD A,(HL+); LD (DE),A; INC DE; DEC B; JR NZ,loop
+// LDH A,(04); LD (2000),A; LD (4000),A; JR start
+static const uint8_t aProgram[] =
+{
+    0x3E, 0x0A, 0xEA, 0x00, 0x00, 0xFB,
+    0x21, 0x00, 0xC0, 0x11, 0x00, 0xA0, 0x06, 0x00,
+    0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA,
+    0xF0, 0x04, 0xEA, 0x00, 0x20, 0xEA, 0x00, 0x40, 0x18, 0xE6,
+};
+
+/**
+ * Sprites, tiles, Timer IRQ every 1024 cycles
+ */
+static void setup(void)
+{
+    bench_load_program(aROM, sizeof(aROM), aProgram, sizeof(aProgram));
+    aROM[0x0147] = 0x1B; // MBC5+RAM+BATTERY
+    aROM[0x0148] = 0x01; // 64 kiB
+    aROM[0x0149] = 0x03; // 32 kiB
+
+    gameboy_init(NULL, aROM, sizeof(aROM));
+    ppu_set_framebuffer(aFramebuffer, PPU_FORMAT_L8);
+    bench_setup_scene(BENCH_OAM);
+    bench_setup_timer();
+    mem_write_u8(0xFFFF, 0x04); // IE: Timer
+}
+
+static int check(void)
+{
+    setup();
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        gameboy_run_frame();
+
+    uint32_t size = state_save(aState[0], STATE_SIZE_MAX);
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        gameboy_run_frame();
+    state_save(aState[1], STATE_SIZE_MAX);
+    memcpy(aReference, aFramebuffer, sizeof(aReference));
+
+    // From a fresh emulator
+    setup();
+    if (!state_load(aState[0], size))
+        return -1;
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        gameboy_run_frame();
+    state_save(aState[2], STATE_SIZE_MAX);
+
+    if ((memcmp(aState[1], aState[2], size) != 0) || (memcmp(aReference, aFramebuffer, sizeof(aReference)) != 0))
+        return -1;
+
+    // Other version
+    aState[0][4]++;
+    return state_load(aState[0], size) ? -1 : 0;
+}
+
+int main(void)
+{
+    if (check() != 0)
+    {
+        printf("state loaded differs\n");
+        return EXIT_FAILURE;
+    }
+
+    setup();
+    gameboy_run_frame();
+    uint32_t size = state_size();
+
+    double t0 = host_time();
+    for (uint32_t i = 0 ; i < BENCH_LOOPS ; i++)
+        state_save(aState[0], STATE_SIZE_MAX);
+    double save = (host_time() - t0) / BENCH_LOOPS;
+
+    t0 = host_time();
+    for (uint32_t i = 0 ; i < BENCH_LOOPS ; i++)
+        state_load(aState[0], size);
+    double load = (host_time() - t0) / BENCH_LOOPS;
+
+    printf("state size: %u bytes\n", size);
+    printf("save:       %.2f us\n", save * 1e6);
+    printf("load:       %.2f us\n", load * 1e6);
+
+    return EXIT_SUCCESS;
+}
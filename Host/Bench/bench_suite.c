@@ -0,0 +1,244 @@
+/*
+ * bench_suite.c
+ *
+ *  Emulation throughput benchmark: run fixed workloads for a fixed number of
+ *  emulated frames and report throughput and per-subsystem time share as JSON.
+ *
+ *  The core is built with GAMEBOY_PROFILE, a timer signal samples the zone
+ *  being executed.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/cpu.h>
+#include <gameboy/idle.h>
+#include <gameboy/mem.h>
+#include <gameboy/ppu.h>
+#include <gameboy/profile.h>
+#include <bench.h>
+#include <host.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_FRAMES            1800    // 30 s of emulated time
+#define BENCH_SAMPLE_PERIOD_NS  100000  // 10 kHz
+
+#ifdef CPU_DISPATCH_SWITCH
+#define BENCH_DISPATCH          "switch"
+#else
+#define BENCH_DISPATCH          "table"
+#endif
+
+#ifdef CPU_LAZY_FLAGS
+#define BENCH_FLAGS             "lazy"
+#else
+#define BENCH_FLAGS             "eager"
+#endif
+
+struct workload_t
+{
+    const char *pName;
+    const uint8_t *pProgram;
+    uint16_t size;
+    void (*setup)(void);
+};
+
+// ADD A,B; ADC A,C; SUB D; AND E; XOR H; OR L; CP B; INC A; DEC C; JR -11
+static const uint8_t aALU[] =
+{
+    0x80, 0x89, 0x92, 0xA3, 0xAC, 0xB5, 0xB8, 0x3C, 0x0D, 0x18, 0xF5,
+};
+
+// LD HL,C000; LD DE,D000; LD B,0
+// loop: LD A,(HL+); LD (DE),A; INC DE; DEC B; JR NZ,loop; JR start
+static const uint8_t aMemCopy[] =
+{
+    0x21, 0x00, 0xC0, 0x11, 0x00, 0xD0, 0x06, 0x00,
+    0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA, 0x18, 0xF0,
+};
+
+// LD HL,C000
+// loop: RLC B; RL C; SRL D; SWAP E; BIT 0,A; SET 0,A; RES 0,A; RL (HL); JR loop
+static const uint8_t aPrefixCB[] =
+{
+    0x21, 0x00, 0xC0,
+    0xCB, 0x00, 0xCB, 0x11, 0xCB, 0x3A, 0xCB, 0x33,
+    0xCB, 0x47, 0xCB, 0xC7, 0xCB, 0x87, 0xCB, 0x16,
+    0x18, 0xEE,
+};
+
+// loop: NOP; JR loop
+static const uint8_t aIdle[] =
+{
+    0x00, 0x18, 0xFD,
+};
+
+// EI; loop: HALT; JR loop (woken up by V-Blank IRQ)
+static const uint8_t aHalt[] =
+{
+    0xFB, 0x76, 0x18, 0xFD,
+};
+
+// Wait for LY = 0x90 then for LY != 0x90, without HALT
+// loop: LDH A,(44); CP 90; JR NZ,loop; wait: LDH A,(44); CP 90; JR Z,wait; JR loop
+static const uint8_t aPoll[] =
+{
+    0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA,
+    0xF0, 0x44, 0xFE, 0x90, 0x28, 0xFA,
+    0x18, 0xF2,
+};
+
+// EI; loop: HALT; JR loop. V-Blank IRQ: LD A,C0; JP FF80 (OAM DMA routine)
+static const uint8_t aDMA[] =
+{
+    0xFB, 0x76, 0x18, 0xFD,
+};
+
+/**
+ * Scene with every sprite visible and all layers enabled
+ */
+static void setup_ppu(void)
+{
+    bench_setup_scene(BENCH_OAM);
+}
+
+/**
+ * Sprites updated in SRAM and copied by OAM DMA on every V-Blank, as games do
+ */
+static void setup_dma(void)
+{
+    bench_setup_scene(BENCH_OAM);
+    bench_setup_scene(BENCH_SRAM);
+    bench_setup_dma();
+    mem_write_u8(0xFFFF, 0x01); // IE: V-Blank
+}
+
+/**
+ * Timer IRQ every 1024 cycles
+ */
+static void setup_timer(void)
+{
+    bench_setup_timer();
+    mem_write_u8(0xFFFF, 0x04); // IE: Timer
+}
+
+/**
+ * Game waiting for V-Blank in HALT
+ */
+static void setup_halt(void)
+{
+    mem_write_u8(0xFFFF, 0x01); // IE: V-Blank
+}
+
+static const struct workload_t aWorkload[] =
+{
+    {"alu",         aALU,       sizeof(aALU),       NULL},
+    {"memcopy",     aMemCopy,   sizeof(aMemCopy),   NULL},
+    {"prefix_cb",   aPrefixCB,  sizeof(aPrefixCB),  NULL},
+    {"ppu",         aIdle,      sizeof(aIdle),      setup_ppu},
+    {"halt",        aHalt,      sizeof(aHalt),      setup_halt},
+    {"poll",        aPoll,      sizeof(aPoll),      NULL},
+    {"dma",         aDMA,       sizeof(aDMA),       setup_dma},
+    {"timer",       aHalt,      sizeof(aHalt),      setup_timer},
+};
+
+static const char *apZoneName[PROFILE_ZONE_NB] =
+{
+    [PROFILE_OTHER] = "other",
+    [PROFILE_CPU]   = "cpu",
+    [PROFILE_MEM]   = "mem",
+    [PROFILE_PPU]   = "ppu",
+    [PROFILE_DMA]   = "dma",
+};
+
+static volatile uint32_t aSamples[PROFILE_ZONE_NB];
+static uint8_t aROM[BENCH_ROM_SIZE];
+static ppu_pixel_t aFramebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+
+static void sample(int sig)
+{
+    (void) sig;
+    aSamples[profile.zone]++;
+}
+
+static void run(const struct workload_t *pWorkload, timer_t timer, int first)
+{
+    bench_load_program(aROM, sizeof(aROM), pWorkload->pProgram, pWorkload->size);
+    if (pWorkload->setup == setup_dma)
+        bench_load_vblank_dma(aROM);
+
+    gameboy_init(NULL, aROM, sizeof(aROM));
+    ppu_set_framebuffer(aFramebuffer, PPU_FORMAT_L8);
+    if (pWorkload->setup)
+        pWorkload->setup();
+
+    memset((void *) aSamples, 0, sizeof(aSamples));
+    profile.instructions = 0;
+    profile.dma_transfers = 0;
+
+    struct itimerspec period = {{0, BENCH_SAMPLE_PERIOD_NS}, {0, BENCH_SAMPLE_PERIOD_NS}};
+    struct itimerspec stop = {{0, 0}, {0, 0}};
+
+    uint32_t start = cpu.cycles;
+    timer_settime(timer, 0, &period, NULL);
+    double t0 = host_time();
+
+    for (uint32_t i = 0 ; i < BENCH_FRAMES ; i++)
+        gameboy_run_frame();
+
+    double t = host_time() - t0;
+    timer_settime(timer, 0, &stop, NULL);
+
+    uint32_t cycles = cpu.cycles - start;
+    uint32_t idle_cycles = 0;
+    for (uint8_t i = 0 ; i < idle.loop_counter ; i++)
+        idle_cycles += idle.aLoop[i].cycles;
+
+    uint32_t total = 0;
+    for (int z = 0 ; z < PROFILE_ZONE_NB ; z++)
+        total += aSamples[z];
+
+    printf("%s    {\n", first ? "" : ",\n");
+    printf("      \"name\": \"%s\",\n", pWorkload->pName);
+    printf("      \"frames\": %u,\n", BENCH_FRAMES);
+    printf("      \"cycles\": %u,\n", cycles);
+    printf("      \"instructions\": %u,\n", profile.instructions);
+    printf("      \"seconds\": %.6f,\n", t);
+    printf("      \"cycles_per_second\": %.0f,\n", cycles / t);
+    printf("      \"instructions_per_second\": %.0f,\n", profile.instructions / t);
+    printf("      \"ns_per_instruction\": %.3f,\n", t * 1e9 / profile.instructions);
+    printf("      \"idle_skipped_cycles\": %u,\n", idle_cycles);
+    printf("      \"dma_transfers\": %u,\n", profile.dma_transfers);
+    printf("      \"samples\": %u,\n", total);
+    printf("      \"share\": {");
+    for (int z = 0 ; z < PROFILE_ZONE_NB ; z++)
+        printf("%s\"%s\": %.4f", z ? ", " : "", apZoneName[z], total ? (double) aSamples[z] / total : 0.0);
+    printf("}\n    }");
+}
+
+int main(void)
+{
+    timer_t timer;
+    struct sigevent sev;
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGPROF;
+
+    signal(SIGPROF, sample);
+    if (timer_create(CLOCK_MONOTONIC, &sev, &timer) != 0)
+    {
+        perror("timer_create");
+        return EXIT_FAILURE;
+    }
+
+    printf("{\n  \"dispatch\": \"%s\",\n  \"flags\": \"%s\",\n  \"workloads\": [\n", BENCH_DISPATCH, BENCH_FLAGS);
+    for (size_t i = 0 ; i < sizeof(aWorkload) / sizeof(aWorkload[0]) ; i++)
+        run(&aWorkload[i], timer, i == 0);
+    printf("\n  ]\n}\n");
+
+    timer_delete(timer);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/*
+ * bench_tile.c
+ *
+ *  Host micro-benchmark of the 2bpp tile row decoder selected at compile
+ *  time against the scalar reference. Checks first that both give the same
+ *  output for every row value.
+ */
+
+#include <gameboy/tile.h>
+#include <host.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ROWS      4096    // 512 tiles
+#define BENCH_LOOPS     5000
+
+static uint8_t aData[BENCH_ROWS * 2];
+static uint8_t aIndex[BENCH_ROWS * TILE_WIDTH];
+static uint8_t aReference[BENCH_ROWS * TILE_WIDTH];
+
+/**
+ * Every (low, high) bitplane pair, decoded by chunks of 1 to 7 rows so that
+ * the tail of the vector decoders is exercised too
+ */
+static int check(void)
+{
+    for (uint32_t base = 0 ; base < 65536 ; base += BENCH_ROWS)
+    {
+        for (uint32_t i = 0 ; i < BENCH_ROWS ; i++)
+        {
+            aData[i * 2 + 0] = (base + i) & 0xFF;
+            aData[i * 2 + 1] = (base + i) >> 8;
+        }
+
+        memset(aIndex, 0xAA, sizeof(aIndex));
+        for (uint16_t done = 0, n = 1 ; done < BENCH_ROWS ; done += n, n = (n % 7) + 1)
+        {
+            if (n > BENCH_ROWS - done)
+                n = BENCH_ROWS - done;
+            tile_decode_rows(&aData[done * 2], &aIndex[done * TILE_WIDTH], n);
+        }
+
+        tile_decode_rows_scalar(aData, aReference, BENCH_ROWS);
+        if (memcmp(aIndex, aReference, sizeof(aReference)) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static double bench(void (*decode)(const uint8_t *, uint8_t *, uint16_t))
+{
+    double t0 = host_time();
+
+    for (int loop = 0 ; loop < BENCH_LOOPS ; loop++)
+    {
+        decode(aData, aIndex, BENCH_ROWS);
+        __asm__ volatile("" : : "r" (aIndex) : "memory");
+    }
+
+    return (double) BENCH_ROWS * BENCH_LOOPS / (host_time() - t0) / 1e6;
+}
+
+int main(void)
+{
+#ifdef TILE_DECODER_AVX2
+    // Built with -mavx2 on any x86 host, which may not run it
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        printf("%s: not supported by this CPU, skipped\n", TILE_DECODER_NAME);
+        return EXIT_SUCCESS;
+    }
+#endif
+
+    if (check() != 0)
+    {
+        printf("%s: output differs from scalar reference\n", TILE_DECODER_NAME);
+        return EXIT_FAILURE;
+    }
+
+    srand(1);
+    for (int i = 0 ; i < BENCH_ROWS * 2 ; i++)
+        aData[i] = rand();
+
+    printf("decoder %-6s %8.1f Mrows/s (bit-identical)\n", TILE_DECODER_NAME, bench(tile_decode_rows));
+    printf("scalar         %8.1f Mrows/s\n", bench(tile_decode_rows_scalar));
+
+    return EXIT_SUCCESS;
+}
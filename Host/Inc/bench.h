@@ -0,0 +1,27 @@
+/*
+ * bench.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_BENCH_H_
+#define INC_BENCH_H_
+
+#include <stdint.h>
+
+#define BENCH_RUNS          5       // Best run is kept, the host is noisy
+
+#define BENCH_ROM_SIZE      0x8000
+#define BENCH_ROM_ENTRY     0x0100
+
+#define BENCH_OAM           0xFE00
+#define BENCH_SRAM          0xC000  // Sprite table copied by OAM DMA
+
+void bench_load_program(uint8_t *pROM, uint32_t Size, const uint8_t *pProgram, uint32_t ProgramSize);
+void bench_load_vblank_dma(uint8_t *pROM);
+void bench_setup_scene(uint16_t Table);
+void bench_setup_dma(void);
+void bench_setup_timer(void);
+
+#endif /* INC_BENCH_H_ */
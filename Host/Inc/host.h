@@ -0,0 +1,19 @@
+/*
+ * host.h
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#ifndef INC_HOST_H_
+#define INC_HOST_H_
+
+#include <stdint.h>
+
+uint8_t* host_load_file(const char *pPath, uint32_t *pSize);
+int host_save_file(const char *pPath, const uint8_t *pData, uint32_t Size);
+uint64_t* host_load_hashes(const char *pPath, uint32_t *pCount);
+double host_time(void);
+uint32_t host_time_us(void);
+
+#endif /* INC_HOST_H_ */
@@ -0,0 +1,77 @@
+/*
+ * bench.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ *
+ *  Workload shared by the host benchmarks, so that their figures compare.
+ */
+
+#include <bench.h>
+#include <gameboy/mem.h>
+#include <string.h>
+
+// HRAM: LDH (46),A; LD A,28; wait: DEC A; JR NZ,wait; RETI
+static const uint8_t aDMARoutine[] =
+{
+    0xE0, 0x46, 0x3E, 0x28, 0x3D, 0x20, 0xFD, 0xD9,
+};
+
+/**
+ * Clear the ROM, copy the program at the entry point, RETI on every IRQ vector
+ */
+void bench_load_program(uint8_t *pROM, uint32_t Size, const uint8_t *pProgram, uint32_t ProgramSize)
+{
+    memset(pROM, 0x00, Size);
+    memcpy(&pROM[BENCH_ROM_ENTRY], pProgram, ProgramSize);
+    for (uint16_t addr = 0x40 ; addr <= 0x60 ; addr += 8)
+        pROM[addr] = 0xD9; // RETI
+}
+
+/**
+ * V-Blank IRQ: LD A,C0; JP FF80, OAM DMA from SRAM by the routine of bench_setup_dma()
+ */
+void bench_load_vblank_dma(uint8_t *pROM)
+{
+    memcpy(&pROM[0x40], (const uint8_t []) {0x3E, BENCH_SRAM >> 8, 0xC3, 0x80, 0xFF}, 5);
+}
+
+/**
+ * Every sprite visible through both palettes, tiles filled, all layers enabled.
+ * The sprite table is written at Table: BENCH_OAM, or BENCH_SRAM for OAM DMA
+ */
+void bench_setup_scene(uint16_t Table)
+{
+    for (uint16_t i = 0 ; i < 40 ; i++)
+    {
+        mem_write_u8(Table + i * 4 + 0, 16 + (i % 10) * 4);    // Y
+        mem_write_u8(Table + i * 4 + 1, 8 + i * 4);            // X
+        mem_write_u8(Table + i * 4 + 2, i);                    // Tile
+        mem_write_u8(Table + i * 4 + 3, (i & 1) << 4);         // Flags: OBP0/1
+    }
+
+    for (uint16_t i = 0 ; i < 0x1800 ; i++)
+        mem_write_u8(0x8000 + i, i * 7);
+
+    mem_write_u8(0xFF48, 0xD2); // OBP0
+    mem_write_u8(0xFF49, 0x1B); // OBP1
+    mem_write_u8(0xFF40, 0xF7); // LCDC: everything on
+}
+
+/**
+ * OAM DMA routine in HRAM, as games do
+ */
+void bench_setup_dma(void)
+{
+    for (uint16_t i = 0 ; i < sizeof(aDMARoutine) ; i++)
+        mem_write_u8(0xFF80 + i, aDMARoutine[i]);
+}
+
+/**
+ * Timer IRQ every 1024 cycles: TIMA at 262144 Hz from 0. IE is left to the caller
+ */
+void bench_setup_timer(void)
+{
+    mem_write_u8(0xFF06, 0x00); // TMA
+    mem_write_u8(0xFF07, 0x05); // TAC: enabled, 262144 Hz
+}
@@ -0,0 +1,420 @@
+/*
+ * gbbatch.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ *
+ *  Batch runner: run every ROM of the directories given across the host
+ *  cores, one emulator per thread (core built with GAMEBOY_THREADS). A ROM
+ *  is a test case with the optional files next to it: rom.gbm, an input
+ *  movie played from its start state, and rom.hash, the frame hashes to
+ *  verify as written by gbrun -x. ROMs are dealt to a queue per thread, a
+ *  thread out of work steals from the others.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/movie.h>
+#include <gameboy/ppu.h>
+#include <host.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GBBATCH_FRAMES_DEFAULT  600
+#define GBBATCH_THREADS_MAX     256
+#define GBBATCH_PATH_MAX        4096
+
+enum job_status_t
+{
+    JOB_RUN = 0,    // No golden hashes
+    JOB_PASS,
+    JOB_FAIL,
+    JOB_ERROR,
+};
+
+struct job_t
+{
+    char *pPath;            // ROM
+    enum job_status_t status;
+    const char *pError;
+    uint32_t frames;        // Run
+    uint32_t mismatch;      // First frame differing from the golden hashes
+    uint64_t hash;          // Last frame run
+    double time;            // CPU time of the thread
+};
+
+// Jobs dealt to a thread: the owner pops from the bottom, thieves take from
+// the top. Jobs last from milliseconds to minutes, a lock per queue costs
+// nothing next to them
+struct job_queue_t
+{
+    pthread_mutex_t lock;
+    uint32_t *pJob;
+    uint32_t top;
+    uint32_t bottom;
+};
+
+struct batch_t
+{
+    struct job_t *pJob;
+    uint32_t job_nb;
+    struct job_queue_t *pQueue;
+    uint32_t thread_nb;
+    uint8_t *pBootROM;      // Shared, only read
+    uint32_t boot_size;
+    uint32_t frames;        // 0: length of the movie or golden hashes
+};
+
+static struct batch_t batch;
+
+static const char *apStatusName[] =
+{
+    [JOB_RUN]   = "RUN",
+    [JOB_PASS]  = "PASS",
+    [JOB_FAIL]  = "FAIL",
+    [JOB_ERROR] = "ERROR",
+};
+
+static void usage(const char *pName)
+{
+    fprintf(stderr, "Usage: %s [-b bootrom] [-n frames] [-j threads] dir|rom.gb...\n", pName);
+}
+
+static bool queue_pop(struct job_queue_t *pQueue, uint32_t *pJob)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&pQueue->lock);
+    if (pQueue->bottom > pQueue->top)
+    {
+        *pJob = pQueue->pJob[--pQueue->bottom];
+        found = true;
+    }
+    pthread_mutex_unlock(&pQueue->lock);
+
+    return found;
+}
+
+static bool queue_steal(struct job_queue_t *pQueue, uint32_t *pJob)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&pQueue->lock);
+    if (pQueue->bottom > pQueue->top)
+    {
+        *pJob = pQueue->pJob[pQueue->top++];
+        found = true;
+    }
+    pthread_mutex_unlock(&pQueue->lock);
+
+    return found;
+}
+
+/**
+ * Next job of a thread, its own first. Jobs are all dealt at start, false
+ * when every queue is empty
+ */
+static bool get_job(uint32_t Thread, uint32_t *pJob)
+{
+    if (queue_pop(&batch.pQueue[Thread], pJob))
+        return true;
+
+    for (uint32_t i = 1 ; i < batch.thread_nb ; i++)
+        if (queue_steal(&batch.pQueue[(Thread + i) % batch.thread_nb], pJob))
+            return true;
+
+    return false;
+}
+
+/**
+ * CPU time of the calling thread: jobs sharing a core don't count each other
+ */
+static double get_thread_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Path of a test case file: the ROM path with another extension
+ */
+static const char *get_case_path(char *pBuffer, const char *pROMPath, const char *pExtension)
+{
+    const char *pDot = strrchr(pROMPath, '.');
+    const char *pSlash = strrchr(pROMPath, '/');
+    int length = (pDot && (!pSlash || (pDot > pSlash))) ? pDot - pROMPath : (int) strlen(pROMPath);
+
+    snprintf(pBuffer, GBBATCH_PATH_MAX, "%.*s%s", length, pROMPath, pExtension);
+    return pBuffer;
+}
+
+/**
+ * Run a test case on the emulator of the calling thread, stop at the first
+ * frame differing from the golden hashes
+ */
+static void run_job(struct job_t *pJob)
+{
+    char aPath[GBBATCH_PATH_MAX];
+    uint32_t rom_size = 0;
+    uint32_t movie_size = 0;
+    uint32_t golden_nb = 0;
+
+    uint8_t *pROM = host_load_file(pJob->pPath, &rom_size);
+    if (NULL == pROM)
+    {
+        pJob->status = JOB_ERROR;
+        pJob->pError = "cannot load ROM";
+        return;
+    }
+
+    uint8_t *pMovie = host_load_file(get_case_path(aPath, pJob->pPath, ".gbm"), &movie_size);
+    uint64_t *pGolden = host_load_hashes(get_case_path(aPath, pJob->pPath, ".hash"), &golden_nb);
+
+    gameboy_init(batch.pBootROM, pROM, rom_size);
+    ppu_set_framebuffer(NULL, PPU_FORMAT_L8);
+    ppu_set_frame_hash(true);
+
+    if (pMovie && !movie_play(pMovie, movie_size, movie_rom_hash(pROM, rom_size)))
+    {
+        pJob->status = JOB_ERROR;
+        pJob->pError = "movie of another ROM";
+    }
+    else
+    {
+        uint32_t frames = batch.frames ? batch.frames :
+                          pMovie ? movie.frame_nb :
+                          pGolden ? golden_nb : GBBATCH_FRAMES_DEFAULT;
+        uint32_t frame = 0;
+        double t0 = get_thread_time();
+
+        pJob->status = pGolden ? JOB_PASS : JOB_RUN;
+        for ( ; frame < frames ; frame++)
+        {
+            if (pMovie && !movie_play_frame())
+                break;
+
+            gameboy_run_frame();
+
+            if (pGolden && ((frame >= golden_nb) || (pGolden[frame] != ppu.frame_hash)))
+            {
+                pJob->status = JOB_FAIL;
+                pJob->mismatch = frame++;
+                break;
+            }
+        }
+
+        pJob->time = get_thread_time() - t0;
+        pJob->frames = frame;
+        pJob->hash = ppu.frame_hash;
+    }
+
+    movie_stop();
+    free(pGolden);
+    free(pMovie);
+    free(pROM);
+}
+
+static void *worker(void *pArg)
+{
+    uint32_t thread = (uintptr_t) pArg;
+    uint32_t job;
+
+    while (get_job(thread, &job))
+        run_job(&batch.pJob[job]);
+
+    return NULL;
+}
+
+static bool add_job(const char *pPath)
+{
+    struct job_t *pJob = realloc(batch.pJob, (batch.job_nb + 1) * sizeof(struct job_t));
+    if (NULL == pJob)
+        return false;
+
+    batch.pJob = pJob;
+    memset(&pJob[batch.job_nb], 0, sizeof(struct job_t));
+    pJob[batch.job_nb].pPath = strdup(pPath);
+
+    return pJob[batch.job_nb++].pPath != NULL;
+}
+
+/**
+ * A ROM, or every .gb file of a directory
+ */
+static bool add_path(const char *pPath)
+{
+    DIR *pDir = opendir(pPath);
+    if (NULL == pDir)
+        return add_job(pPath);
+
+    struct dirent *pEntry;
+    bool ok = true;
+
+    while (ok && ((pEntry = readdir(pDir)) != NULL))
+    {
+        char aPath[GBBATCH_PATH_MAX];
+        size_t length = strlen(pEntry->d_name);
+
+        if ((length <= 3) || (strcmp(&pEntry->d_name[length - 3], ".gb") != 0))
+            continue;
+
+        snprintf(aPath, sizeof(aPath), "%s/%s", pPath, pEntry->d_name);
+        ok = add_job(aPath);
+    }
+
+    closedir(pDir);
+    return ok;
+}
+
+static int compare_jobs(const void *pA, const void *pB)
+{
+    return strcmp(((const struct job_t *) pA)->pPath, ((const struct job_t *) pB)->pPath);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pBootPath = NULL;
+    long thread_nb = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:j:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                pBootPath = optarg;
+                break;
+            case 'n':
+                batch.frames = strtoul(optarg, NULL, 0);
+                break;
+            case 'j':
+                thread_nb = strtol(optarg, NULL, 0);
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind == argc)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (pBootPath)
+    {
+        batch.pBootROM = host_load_file(pBootPath, &batch.boot_size);
+        if (NULL == batch.pBootROM)
+        {
+            fprintf(stderr, "Cannot load BootROM %s\n", pBootPath);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (int i = optind ; i < argc ; i++)
+    {
+        if (!add_path(argv[i]))
+        {
+            fprintf(stderr, "Cannot add %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (batch.job_nb == 0)
+    {
+        fprintf(stderr, "No ROM found\n");
+        return EXIT_FAILURE;
+    }
+
+    // Same order, and results, on every run
+    qsort(batch.pJob, batch.job_nb, sizeof(struct job_t), compare_jobs);
+
+    if (thread_nb < 1)
+        thread_nb = 1;
+    if (thread_nb > GBBATCH_THREADS_MAX)
+        thread_nb = GBBATCH_THREADS_MAX;
+    if ((uint32_t) thread_nb > batch.job_nb)
+        thread_nb = batch.job_nb;
+    batch.thread_nb = thread_nb;
+
+    // Jobs dealt round robin, neighbours in a directory often take as long
+    uint32_t capacity = (batch.job_nb + batch.thread_nb - 1) / batch.thread_nb;
+    batch.pQueue = calloc(batch.thread_nb, sizeof(struct job_queue_t));
+    if (NULL == batch.pQueue)
+        return EXIT_FAILURE;
+
+    for (uint32_t i = 0 ; i < batch.thread_nb ; i++)
+    {
+        pthread_mutex_init(&batch.pQueue[i].lock, NULL);
+        batch.pQueue[i].pJob = malloc(capacity * sizeof(uint32_t));
+        if (NULL == batch.pQueue[i].pJob)
+            return EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0 ; i < batch.job_nb ; i++)
+    {
+        struct job_queue_t *pQueue = &batch.pQueue[i % batch.thread_nb];
+        pQueue->pJob[pQueue->bottom++] = i;
+    }
+
+    pthread_t aThread[GBBATCH_THREADS_MAX];
+    double t0 = host_time();
+
+    for (uint32_t i = 0 ; i < batch.thread_nb ; i++)
+    {
+        if (pthread_create(&aThread[i], NULL, worker, (void *) (uintptr_t) i) != 0)
+        {
+            fprintf(stderr, "Cannot start thread %u\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t i = 0 ; i < batch.thread_nb ; i++)
+        pthread_join(aThread[i], NULL);
+
+    double wall = host_time() - t0;
+    double emulation = 0;
+    uint32_t aCount[JOB_ERROR + 1] = {0};
+
+    for (uint32_t i = 0 ; i < batch.job_nb ; i++)
+    {
+        struct job_t *pJob = &batch.pJob[i];
+
+        aCount[pJob->status]++;
+        emulation += pJob->time;
+
+        printf("%-5s  %8u  %7.2f s  %s", apStatusName[pJob->status], pJob->frames, pJob->time, pJob->pPath);
+        if (pJob->status == JOB_RUN)
+            printf("  %016" PRIx64, pJob->hash);
+        else if (pJob->status == JOB_FAIL)
+            printf("  frame %u differs", pJob->mismatch);
+        else if (pJob->status == JOB_ERROR)
+            printf("  %s", pJob->pError);
+        printf("\n");
+
+        free(pJob->pPath);
+    }
+
+    printf("roms:     %u, %u run, %u passed, %u failed, %u errors\n", batch.job_nb,
+           aCount[JOB_RUN], aCount[JOB_PASS], aCount[JOB_FAIL], aCount[JOB_ERROR]);
+    printf("threads:  %u\n", batch.thread_nb);
+    printf("time:     %.2f s, %.2f s of emulation, %.2fx\n", wall, emulation, emulation / wall);
+
+    for (uint32_t i = 0 ; i < batch.thread_nb ; i++)
+    {
+        pthread_mutex_destroy(&batch.pQueue[i].lock);
+        free(batch.pQueue[i].pJob);
+    }
+    free(batch.pQueue);
+    free(batch.pJob);
+    free(batch.pBootROM);
+
+    return (aCount[JOB_FAIL] + aCount[JOB_ERROR]) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
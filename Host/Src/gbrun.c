@@ -0,0 +1,350 @@
+/*
+ * gbrun.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ *
+ *  Headless runner: load a ROM, run N frames and print timing, optionally
+ *  save the last frame rendered as PGM. A save state can be loaded before
+ *  running and written at the end. Rewind snapshots can be captured on every
+ *  frame, the ring footprint is then printed. Input movies are played back,
+ *  or recorded with random button presses. Frame hashes can be printed, or
+ *  verified against a golden list.
+ */
+
+#include <gameboy/gameboy.h>
+#include <gameboy/cpu.h>
+#include <gameboy/idle.h>
+#include <gameboy/joypad.h>
+#include <gameboy/movie.h>
+#include <gameboy/ppu.h>
+#include <gameboy/rewind.h>
+#include <gameboy/state.h>
+#include <host.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GBRUN_FRAMES_DEFAULT    600
+#define GBRUN_PRESS_PERIOD      16      // Frames between random button changes, on average
+
+static void usage(const char *pName)
+{
+    fprintf(stderr, "Usage: %s [-b bootrom] [-n frames] [-k skip|auto] [-s screenshot.pgm]\n"
+                    "       [-l state] [-w state] [-r rewind_kib] [-m movie | -M movie]\n"
+                    "       [-x hashes | -X golden] rom.gb\n", pName);
+}
+
+static int save_pgm(const char *pPath, const ppu_pixel_t *pFramebuffer)
+{
+    FILE *pFile = fopen(pPath, "wb");
+    if (NULL == pFile)
+        return -1;
+
+    fprintf(pFile, "P5\n%d %d\n255\n", PPU_SCREEN_WIDTH, PPU_SCREEN_HEIGHT);
+    for (int i = 0 ; i < PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT ; i++)
+        fputc(255 - pFramebuffer[i] * 85, pFile); // Shade 0 is white
+
+    fclose(pFile);
+    return 0;
+}
+
+/**
+ * Buttons held for the next frame: a new random set now and then, as a
+ * player would press them. Same sequence on every run
+ */
+static uint8_t get_random_buttons(void)
+{
+    static uint32_t seed = 0x12345678;
+    static uint8_t buttons = 0;
+
+    // xorshift32
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    if (seed % GBRUN_PRESS_PERIOD == 0)
+        buttons = seed >> 8;
+
+    return buttons;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pBootPath = NULL;
+    const char *pScreenshotPath = NULL;
+    const char *pLoadStatePath = NULL;
+    const char *pSaveStatePath = NULL;
+    const char *pPlayMoviePath = NULL;
+    const char *pRecordMoviePath = NULL;
+    const char *pHashPath = NULL;
+    const char *pGoldenPath = NULL;
+    static ppu_pixel_t aFramebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+    uint32_t frames = GBRUN_FRAMES_DEFAULT;
+    bool frames_set = false;
+    enum ppu_frame_skip_t frame_skip = PPU_FRAME_SKIP_OFF;
+    uint8_t frame_interval = 1;
+    uint32_t rewind_size = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:k:s:l:w:r:m:M:x:X:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                pBootPath = optarg;
+                break;
+            case 'n':
+                frames = strtoul(optarg, NULL, 0);
+                frames_set = true;
+                break;
+            case 'k': // Render 1 in N frames, or skip frames late for 59.73 Hz
+                if (strcmp(optarg, "auto") == 0)
+                {
+                    frame_skip = PPU_FRAME_SKIP_AUTO;
+                }
+                else
+                {
+                    frame_skip = PPU_FRAME_SKIP_FIXED;
+                    frame_interval = strtoul(optarg, NULL, 0);
+                }
+                break;
+            case 's':
+                pScreenshotPath = optarg;
+                break;
+            case 'l':
+                pLoadStatePath = optarg;
+                break;
+            case 'w':
+                pSaveStatePath = optarg;
+                break;
+            case 'r': // Rewind arena size
+                rewind_size = strtoul(optarg, NULL, 0) * 1024;
+                break;
+            case 'm':
+                pPlayMoviePath = optarg;
+                break;
+            case 'M':
+                pRecordMoviePath = optarg;
+                break;
+            case 'x': // "-" for stdout
+                pHashPath = optarg;
+                break;
+            case 'X':
+                pGoldenPath = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Skipped frames are not hashed
+    if ((optind != argc - 1) || (pPlayMoviePath && pRecordMoviePath) || (pHashPath && pGoldenPath) ||
+        ((pHashPath || pGoldenPath) && (frame_skip != PPU_FRAME_SKIP_OFF)))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint8_t *pBootROM = NULL;
+    uint32_t boot_size = 0;
+    if (pBootPath)
+    {
+        pBootROM = host_load_file(pBootPath, &boot_size);
+        if (NULL == pBootROM)
+        {
+            fprintf(stderr, "Cannot load BootROM %s\n", pBootPath);
+            return EXIT_FAILURE;
+        }
+    }
+
+    uint32_t rom_size = 0;
+    uint8_t *pROM = host_load_file(argv[optind], &rom_size);
+    if (NULL == pROM)
+    {
+        fprintf(stderr, "Cannot load ROM %s\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    gameboy_init(pBootROM, pROM, rom_size);
+    ppu_set_framebuffer(aFramebuffer, PPU_FORMAT_L8);
+    ppu_set_frame_skip(frame_skip, frame_interval, host_time_us);
+
+    if (pLoadStatePath)
+    {
+        uint32_t size = 0;
+        uint8_t *pState = host_load_file(pLoadStatePath, &size);
+
+        if ((NULL == pState) || !state_load(pState, size))
+        {
+            fprintf(stderr, "Cannot load state %s\n", pLoadStatePath);
+            return EXIT_FAILURE;
+        }
+        free(pState);
+    }
+
+    uint8_t *pRewindArena = NULL;
+    if (rewind_size)
+    {
+        pRewindArena = malloc(rewind_size);
+        if ((NULL == pRewindArena) || !rewind_init(pRewindArena, rewind_size, 1))
+        {
+            fprintf(stderr, "Rewind arena of %u bytes too small\n", rewind_size);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Movie played from its start state, all of it unless -n is given
+    uint64_t rom_hash = movie_rom_hash(pROM, rom_size);
+    uint8_t *pMovie = NULL;
+    if (pPlayMoviePath)
+    {
+        uint32_t size = 0;
+        pMovie = host_load_file(pPlayMoviePath, &size);
+
+        if ((NULL == pMovie) || !movie_play(pMovie, size, rom_hash))
+        {
+            fprintf(stderr, "Cannot play movie %s\n", pPlayMoviePath);
+            return EXIT_FAILURE;
+        }
+        if (!frames_set)
+            frames = movie.frame_nb;
+    }
+    else if (pRecordMoviePath)
+    {
+        uint32_t size = MOVIE_HEADER_SIZE + state_size() + (frames + 1) * MOVIE_RUN_SIZE;
+        pMovie = malloc(size);
+
+        if ((NULL == pMovie) || !movie_record(pMovie, size, rom_hash))
+        {
+            fprintf(stderr, "Cannot record movie %s\n", pRecordMoviePath);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *pHashFile = NULL;
+    uint64_t *pGolden = NULL;
+    uint32_t golden_nb = 0;
+    uint32_t mismatch = UINT32_MAX;
+    uint64_t mismatch_hash = 0;
+    if (pHashPath)
+    {
+        pHashFile = (strcmp(pHashPath, "-") == 0) ? stdout : fopen(pHashPath, "w");
+        if (NULL == pHashFile)
+        {
+            fprintf(stderr, "Cannot write hashes %s\n", pHashPath);
+            return EXIT_FAILURE;
+        }
+        ppu_set_frame_hash(true);
+    }
+    else if (pGoldenPath)
+    {
+        pGolden = host_load_hashes(pGoldenPath, &golden_nb);
+        if (NULL == pGolden)
+        {
+            fprintf(stderr, "Cannot load hashes %s\n", pGoldenPath);
+            return EXIT_FAILURE;
+        }
+        if (!frames_set && !pPlayMoviePath)
+            frames = golden_nb;
+        ppu_set_frame_hash(true);
+    }
+
+    uint32_t start = cpu.cycles;
+    uint32_t frame = 0;
+    double t0 = host_time();
+
+    for ( ; frame < frames ; frame++)
+    {
+        if (pPlayMoviePath && !movie_play_frame())
+            break;
+
+        if (pRecordMoviePath)
+        {
+            joypad_set(get_random_buttons());
+            movie_record_frame();
+        }
+
+        gameboy_run_frame();
+        if (pRewindArena)
+            rewind_frame();
+
+        // Hash of the last frame completed
+        if (pHashFile)
+            fprintf(pHashFile, "%u %016" PRIx64 "\n", frame, ppu.frame_hash);
+        else if (pGolden && (mismatch == UINT32_MAX) &&
+                 ((frame >= golden_nb) || (pGolden[frame] != ppu.frame_hash)))
+        {
+            mismatch = frame;
+            mismatch_hash = ppu.frame_hash;
+        }
+    }
+
+    double t = host_time() - t0;
+    uint32_t cycles = cpu.cycles - start;
+    frames = frame;
+
+    // Summary on stderr when the hashes are written on stdout
+    FILE *pReport = (pHashFile == stdout) ? stderr : stdout;
+
+    fprintf(pReport, "frames:   %u\n", frames);
+    fprintf(pReport, "cycles:   %u\n", cycles);
+    fprintf(pReport, "time:     %.3f s\n", t);
+    fprintf(pReport, "fps:      %.1f\n", frames / t);
+    fprintf(pReport, "speed:    %.1fx\n", frames / t / PPU_FRAME_RATE);
+    fprintf(pReport, "skipped:  %u frames\n", ppu.skipped_frame_counter);
+
+    if (pRewindArena)
+        fprintf(pReport, "rewind:   %u snapshots, %.1f s, %u / %u bytes\n", rewind_ring.snapshot_nb,
+                rewind_ring.snapshot_nb / PPU_FRAME_RATE, rewind_footprint(), rewind_size);
+
+    for (uint8_t i = 0 ; i < idle.loop_counter ; i++)
+        fprintf(pReport, "idle:     %04X hits %u skipped %u cycles\n", idle.aLoop[i].pc, idle.aLoop[i].hits, idle.aLoop[i].cycles);
+
+    if (pGolden)
+    {
+        if (mismatch == UINT32_MAX)
+            fprintf(pReport, "hashes:   %u frames match %s\n", frames, pGoldenPath);
+        else if (mismatch >= golden_nb)
+            fprintf(pReport, "hashes:   frame %u not in %s\n", mismatch, pGoldenPath);
+        else
+            fprintf(pReport, "hashes:   frame %u differs, %016" PRIx64 " expected %016" PRIx64 "\n", mismatch,
+                    mismatch_hash, pGolden[mismatch]);
+    }
+
+    if (pScreenshotPath && (save_pgm(pScreenshotPath, aFramebuffer) != 0))
+        fprintf(stderr, "Cannot save %s\n", pScreenshotPath);
+
+    if (pRecordMoviePath)
+    {
+        uint32_t size = movie_stop();
+
+        fprintf(pReport, "movie:    %u frames, %u bytes\n", movie.frame_nb, size);
+        if (host_save_file(pRecordMoviePath, pMovie, size) != 0)
+            fprintf(stderr, "Cannot save movie %s\n", pRecordMoviePath);
+    }
+
+    if (pSaveStatePath)
+    {
+        uint32_t size = state_size();
+        uint8_t *pState = malloc(size);
+
+        if ((NULL == pState) || (state_save(pState, size) == 0) ||
+            (host_save_file(pSaveStatePath, pState, size) != 0))
+            fprintf(stderr, "Cannot save state %s\n", pSaveStatePath);
+        free(pState);
+    }
+
+    if (pHashFile && (pHashFile != stdout))
+        fclose(pHashFile);
+
+    free(pGolden);
+    free(pMovie);
+    free(pRewindArena);
+    free(pROM);
+    free(pBootROM);
+    return (mismatch == UINT32_MAX) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,110 @@
+/*
+ * host.c
+ *
+ *  Created on: 17 oct. 2026
+ *      Author: Guillaume Fouilleul
+ */
+
+#include <host.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ROM_SIZE_MIN    0x8000 // ROM Bank #0 & #1
+
+/**
+ * Load a whole file, padded with 0xFF up to 32 kiB so that both ROM banks are mapped
+ */
+uint8_t* host_load_file(const char *pPath, uint32_t *pSize)
+{
+    FILE *pFile = fopen(pPath, "rb");
+    if (NULL == pFile)
+        return NULL;
+
+    fseek(pFile, 0, SEEK_END);
+    long size = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    uint32_t alloc = (size < ROM_SIZE_MIN) ? ROM_SIZE_MIN : size;
+    uint8_t *pBuffer = malloc(alloc);
+    if (NULL == pBuffer)
+    {
+        fclose(pFile);
+        return NULL;
+    }
+
+    memset(pBuffer, 0xFF, alloc);
+    if (fread(pBuffer, 1, size, pFile) != (size_t) size)
+    {
+        free(pBuffer);
+        fclose(pFile);
+        return NULL;
+    }
+
+    fclose(pFile);
+    *pSize = alloc;
+    return pBuffer;
+}
+
+int host_save_file(const char *pPath, const uint8_t *pData, uint32_t Size)
+{
+    FILE *pFile = fopen(pPath, "wb");
+    if (NULL == pFile)
+        return -1;
+
+    size_t written = fwrite(pData, 1, Size, pFile);
+    if ((fclose(pFile) != 0) || (written != Size))
+        return -1;
+
+    return 0;
+}
+
+/**
+ * Load a frame hash list, one "frame hash" line per frame as written by
+ * gbrun -x
+ */
+uint64_t* host_load_hashes(const char *pPath, uint32_t *pCount)
+{
+    FILE *pFile = fopen(pPath, "r");
+    if (NULL == pFile)
+        return NULL;
+
+    uint32_t count = 0, capacity = 0;
+    uint64_t *pHash = NULL;
+    unsigned frame;
+    uint64_t hash;
+
+    while (fscanf(pFile, "%u %" SCNx64, &frame, &hash) == 2)
+    {
+        if (frame != count)
+            break;
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            uint64_t *pGrown = realloc(pHash, capacity * sizeof(uint64_t));
+            if (NULL == pGrown)
+                break;
+            pHash = pGrown;
+        }
+        pHash[count++] = hash;
+    }
+
+    fclose(pFile);
+    *pCount = count;
+    return pHash;
+}
+
+double host_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint32_t host_time_us(void)
+{
+    return (uint64_t) (host_time() * 1e6);
+}